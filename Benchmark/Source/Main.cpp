@@ -0,0 +1,509 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Offline benchmark for the SimpleEQ processing path. Builds the processor
+    without an editor and drives processBlock over synthetic buffers for a
+    sweep of block sizes, sample rates, slopes, automation densities and
+    filter engines (biquad vs. state variable filter). With --analyzer every
+    configuration also runs with the spectrum analyser feed enabled, which
+    is what processBlock costs while an editor is open, and --linear-phase
+    adds runs in linear phase mode (FIR convolution instead of the cascades).
+    --precision compares float processing, double cascades with float I/O
+    (mixed) and a double precision host buffer. --bands sets how many of the
+    EQ bands are enabled, --dynamic adds runs with those bells in dynamic
+    mode and --stereo compares the stereo modes. --silence adds runs that
+    feed digital silence after the warm-up, to measure an idle instance.
+    --smoothing adds runs with parameter smoothing on. --parallel adds runs
+    with multithreading on, with smoothing off and on; against the serial
+    runs over --channels and the block sizes it shows where spreading the
+    lane groups over worker threads starts to pay off
+    (minParallelGroupSamples).
+
+    The allocations column counts operator new and, on Linux with glibc,
+    malloc / calloc / realloc during the timed processBlock calls; on other
+    platforms memory taken straight from malloc goes unnoticed there. Built
+    with SIMPLEEQ_RT_CHECKS=1 (the RealtimeChecks configuration) the
+    processor checks every block itself: allocations and frees through
+    new / delete or malloc and mutex locks are counted, the first block of
+    a run that wasn't real-time safe is described on stderr, and the exit
+    code fails on any of them.
+
+    usage: SimpleEQBenchmark [--seconds=<audio seconds per run>] [--quick] [--analyzer]
+                             [--channels=<comma separated channel counts, e.g. 1,2,6,12,16>]
+                             [--oversampling=<comma separated factors out of 1,2,4>] [--linear-phase]
+                             [--precision=<comma separated modes out of float,mixed,double>]
+                             [--bands=<comma separated enabled band counts, e.g. 1,4,16>] [--dynamic]
+                             [--stereo=<comma separated modes out of linked,lr,ms>] [--silence] [--smoothing] [--parallel]
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+#include "../../Source/RealtimeChecks.h"
+
+#include <algorithm>
+#include <iostream>
+#include <new>
+
+//==============================================================================
+// count heap allocations made by the thread that is currently measuring processBlock,
+// RealtimeChecks replaces operator new itself and reports them instead
+namespace AllocationCounter
+{
+    static thread_local bool isCounting = false;
+    static std::atomic<int64_t> numAllocations { 0 };
+
+    struct ScopedCount
+    {
+        ScopedCount() { isCounting = true; }
+        ~ScopedCount() { isCounting = false; }
+    };
+
+    static void count() noexcept
+    {
+        if (isCounting)
+            numAllocations.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+#if ! SIMPLEEQ_RT_CHECKS
+// with glibc malloc, calloc and realloc are counted too (juce::HeapBlock, AudioBuffer resizes) and
+// operator new is counted through them; elsewhere only operator new is seen
+#if JUCE_LINUX && defined (__GLIBC__)
+ #define SIMPLEEQ_COUNT_MALLOC 1
+
+extern "C"
+{
+    void* __libc_malloc (size_t);
+    void* __libc_calloc (size_t, size_t);
+    void* __libc_realloc (void*, size_t);
+
+    void* malloc (size_t size) noexcept
+    {
+        AllocationCounter::count();
+        return __libc_malloc(size);
+    }
+
+    void* calloc (size_t numElements, size_t elementSize) noexcept
+    {
+        AllocationCounter::count();
+        return __libc_calloc(numElements, elementSize);
+    }
+
+    void* realloc (void* ptr, size_t size) noexcept
+    {
+        AllocationCounter::count();
+        return __libc_realloc(ptr, size);
+    }
+}
+#else
+ #define SIMPLEEQ_COUNT_MALLOC 0
+#endif
+
+void* operator new (std::size_t size)
+{
+   #if ! SIMPLEEQ_COUNT_MALLOC
+    AllocationCounter::count();
+   #endif
+
+    if (auto* ptr = std::malloc(size == 0 ? 1 : size))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void operator delete (void* ptr) noexcept                { std::free(ptr); }
+void operator delete (void* ptr, std::size_t) noexcept   { std::free(ptr); }
+void* operator new[] (std::size_t size)                  { return operator new (size); }
+void operator delete[] (void* ptr) noexcept              { std::free(ptr); }
+void operator delete[] (void* ptr, std::size_t) noexcept { std::free(ptr); }
+#endif
+
+//==============================================================================
+enum class Precision { Float, Mixed, Double };
+
+struct BenchmarkConfig
+{
+    int blockSize;
+    double sampleRate;
+    FilterSlope slope;
+    int automationInterval; // automate a parameter every n blocks, 0 = static parameters
+    FilterEngine engine;
+    int numChannels;
+    bool analyzer;
+    int oversampling; // 0 = off, 1 = 2x, 2 = 4x
+    bool linearPhase;
+    Precision precision;
+    int numBands;
+    bool dynamic;
+    StereoMode stereoMode;
+    bool silentInput;
+    bool smoothing;
+    bool parallel;
+};
+
+struct BenchmarkResult
+{
+    double nsPerSample;
+    double p50Ms, p99Ms, maxMs;
+    int64_t allocations;
+    int64_t locks;        // SIMPLEEQ_RT_CHECKS builds only
+    int64_t unsafeBlocks; // SIMPLEEQ_RT_CHECKS builds only
+    double idleBlocks; // share of the timed blocks that skipped the DSP
+};
+
+static void setParameter(SimpleEQAudioProcessor& processor, const juce::String& parameterID, float value)
+{
+    auto* param = processor.apvts.getParameter(parameterID);
+    param->setValueNotifyingHost(param->convertTo0to1(value));
+}
+
+static void setChainSettings(SimpleEQAudioProcessor& processor, FilterSlope slope, FilterEngine engine, int oversampling, bool linearPhase,
+                             Precision precision, int numBands, bool dynamic, StereoMode stereoMode, bool smoothing, bool parallel)
+{
+    // every section of the chain active, so the numbers reflect the full cascade
+    setParameter(processor, "LowCut Freq", 80.f);
+    setParameter(processor, "HighCut Freq", 12000.f);
+    setParameter(processor, "Peak Freq", 1000.f);
+    setParameter(processor, "Peak Gain", 6.f);
+    setParameter(processor, "Peak Quality", 1.f);
+
+    // the first numBands bands on, the ones after the peak at their default frequencies alternating boost and cut
+    for (int band = 0; band < maxBands; ++band)
+    {
+        const auto ids = getBandParameterIDs(band);
+
+        setParameter(processor, ids.enabled, band < numBands ? 1.f : 0.f);
+
+        if (band > 0)
+            setParameter(processor, ids.gain, (band % 2) == 0 ? 3.f : -3.f);
+
+        // a threshold low enough for the noise to keep every detector working
+        setParameter(processor, ids.dynamic, dynamic ? 1.f : 0.f);
+        setParameter(processor, ids.threshold, -40.f);
+
+        // in the split stereo modes every band but the first runs on one side of the pair, alternating
+        setParameter(processor, ids.channel, band == 0 ? 0.f : (float)(1 + band % 2));
+    }
+
+    setParameter(processor, "LowCut Slope", (float)slope);
+    setParameter(processor, "HighCut Slope", (float)slope);
+    setParameter(processor, "Filter Engine", (float)engine);
+    setParameter(processor, "Oversampling", (float)oversampling);
+    setParameter(processor, "Phase Mode", linearPhase ? 1.f : 0.f);
+    setParameter(processor, "Precision", precision == Precision::Mixed ? 1.f : 0.f);
+    setParameter(processor, "Stereo Mode", (float)stereoMode);
+    setParameter(processor, "Smoothing", smoothing ? 1.f : 0.f);
+    setParameter(processor, "Multithreading", parallel ? 1.f : 0.f);
+}
+
+static double ticksToMs(int64_t ticks)
+{
+    return juce::Time::highResolutionTicksToSeconds(ticks) * 1000.0;
+}
+
+template <typename SampleType>
+static BenchmarkResult runBenchmark(const BenchmarkConfig& config, double secondsOfAudio)
+{
+    SimpleEQAudioProcessor processor;
+    setChainSettings(processor, config.slope, config.engine, config.oversampling, config.linearPhase, config.precision, config.numBands, config.dynamic,
+                     config.stereoMode, config.smoothing, config.parallel);
+
+    // main buses only, the sidechain stays disconnected
+    auto layout = processor.getBusesLayout();
+    layout.inputBuses.getReference(0) = juce::AudioChannelSet::canonicalChannelSet(config.numChannels);
+    layout.outputBuses.getReference(0) = juce::AudioChannelSet::canonicalChannelSet(config.numChannels);
+
+    for (int bus = 1; bus < layout.inputBuses.size(); ++bus)
+        layout.inputBuses.getReference(bus) = juce::AudioChannelSet::disabled();
+
+    if (! processor.setBusesLayout(layout))
+        std::cerr << "unsupported channel count: " << config.numChannels << std::endl;
+
+    processor.setProcessingPrecision(std::is_same<SampleType, double>::value ? juce::AudioProcessor::doublePrecision
+                                                                             : juce::AudioProcessor::singlePrecision);
+    processor.setRateAndBufferSizeDetails(config.sampleRate, config.blockSize);
+    processor.prepareToPlay(config.sampleRate, config.blockSize);
+    processor.setAnalyzerEnabled(config.analyzer);
+
+    const int numChannels = processor.getTotalNumOutputChannels();
+    const int numBlocks = juce::jmax(1, (int)(secondsOfAudio * config.sampleRate) / config.blockSize);
+
+    juce::AudioBuffer<SampleType> buffer(numChannels, config.blockSize);
+    juce::MidiBuffer midi;
+    juce::Random random(0x5eed);
+
+    auto fillNoise = [&]
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+            for (int i = 0; i < config.blockSize; ++i)
+                buffer.setSample(ch, i, (SampleType)(random.nextFloat() * 2.f - 1.f));
+    };
+
+    // stands in for the analyser thread, outside the timed region
+    std::vector<float> analyzerSamples((size_t)config.blockSize);
+
+    auto drainAnalyzer = [&]
+    {
+        for (auto* fifo : { &processor.getPreEqFifo(), &processor.getPostEqFifo() })
+            while (fifo->pop(analyzerSamples.data(), config.blockSize) > 0) {}
+    };
+
+    // warm up caches and let the coefficient thread settle
+    for (int i = 0; i < 16; ++i)
+    {
+        fillNoise();
+        processor.processBlock(buffer, midi);
+        drainAnalyzer();
+    }
+
+    std::vector<double> blockTimesMs;
+    blockTimesMs.reserve((size_t)numBlocks);
+
+    int64_t totalTicks = 0;
+    int numIdleBlocks = 0;
+    int64_t numLocks = 0, numUnsafeBlocks = 0;
+    AllocationCounter::numAllocations = 0;
+
+    for (int block = 0; block < numBlocks; ++block)
+    {
+        if (config.silentInput)
+            buffer.clear();
+        else
+            fillNoise();
+
+        if (config.automationInterval > 0 && block % config.automationInterval == 0)
+            setParameter(processor, "Peak Freq", juce::mapToLog10(random.nextFloat(), 20.f, 20000.f));
+
+        auto start = juce::Time::getHighResolutionTicks();
+        {
+            AllocationCounter::ScopedCount count;
+            processor.processBlock(buffer, midi);
+        }
+        auto elapsed = juce::Time::getHighResolutionTicks() - start;
+
+        totalTicks += elapsed;
+        blockTimesMs.push_back(ticksToMs(elapsed));
+
+        if (processor.getProcessingState() != SimpleEQAudioProcessor::Processing)
+            ++numIdleBlocks;
+
+        // the processor checked the block itself, describe the first one of the run that wasn't clean
+        const auto& report = RealtimeChecks::getLastReport();
+
+        if (! report.isClean())
+        {
+            if (numUnsafeBlocks++ == 0)
+                std::cerr << "block " << block << " is not real-time safe: " << RealtimeChecks::describe(report) << std::endl;
+
+            AllocationCounter::numAllocations += report.numAllocations;
+            numLocks += report.numLocks;
+        }
+
+        drainAnalyzer();
+    }
+
+    processor.releaseResources();
+
+    std::sort(blockTimesMs.begin(), blockTimesMs.end());
+
+    auto percentile = [&](double p) { return blockTimesMs[(size_t)(p * (blockTimesMs.size() - 1))]; };
+
+    BenchmarkResult result;
+    result.nsPerSample = juce::Time::highResolutionTicksToSeconds(totalTicks) * 1.0e9 / ((double)numBlocks * config.blockSize);
+    result.p50Ms = percentile(0.5);
+    result.p99Ms = percentile(0.99);
+    result.maxMs = blockTimesMs.back();
+    result.allocations = AllocationCounter::numAllocations.load();
+    result.locks = numLocks;
+    result.unsafeBlocks = numUnsafeBlocks;
+    result.idleBlocks = (double)numIdleBlocks / numBlocks;
+
+    return result;
+}
+
+static juce::String slopeName(FilterSlope slope)
+{
+    return juce::String(12 + 12 * (int)slope) + "dB";
+}
+
+static juce::String precisionName(Precision precision)
+{
+    return precision == Precision::Double ? "double" : precision == Precision::Mixed ? "mixed" : "float";
+}
+
+static juce::String stereoModeName(StereoMode stereoMode)
+{
+    return stereoMode == StereoMode::MidSide ? "ms" : stereoMode == StereoMode::LeftRight ? "lr" : "linked";
+}
+
+static juce::String engineName(FilterEngine engine)
+{
+    return engine == FilterEngine::Svf ? "SVF" : "Biquad";
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args(argc, argv);
+
+    double secondsOfAudio = 2.0;
+    if (args.containsOption("--seconds"))
+        secondsOfAudio = juce::jmax(0.1, args.getValueForOption("--seconds").getDoubleValue());
+
+    const bool quick = args.containsOption("--quick");
+    const bool withAnalyzer = args.containsOption("--analyzer");
+
+    std::vector<int> blockSizes { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+    std::vector<double> sampleRates { 44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0 };
+    std::vector<FilterSlope> slopes { _12dB, _24dB, _36dB, _48dB };
+    std::vector<int> automationIntervals { 0, 16, 1 };
+    std::vector<FilterEngine> engines { FilterEngine::Biquad, FilterEngine::Svf };
+    std::vector<int> channelCounts { 2 };
+    std::vector<bool> analyzerStates { false };
+    std::vector<int> oversamplingFactors { 0 };
+
+    if (args.containsOption("--oversampling"))
+    {
+        oversamplingFactors.clear();
+
+        for (auto& token : juce::StringArray::fromTokens(args.getValueForOption("--oversampling"), ",", {}))
+            oversamplingFactors.push_back(token.getIntValue() >= 4 ? 2 : token.getIntValue() >= 2 ? 1 : 0);
+    }
+
+    if (withAnalyzer)
+        analyzerStates.push_back(true);
+
+    std::vector<bool> phaseModes { false };
+    std::vector<Precision> precisions { Precision::Float };
+
+    if (args.containsOption("--precision"))
+    {
+        precisions.clear();
+
+        for (auto& token : juce::StringArray::fromTokens(args.getValueForOption("--precision"), ",", {}))
+            precisions.push_back(token == "double" ? Precision::Double : token == "mixed" ? Precision::Mixed : Precision::Float);
+    }
+
+    if (args.containsOption("--linear-phase"))
+        phaseModes.push_back(true);
+
+    std::vector<int> bandCounts { 1 };
+    std::vector<bool> dynamicStates { false };
+
+    if (args.containsOption("--dynamic"))
+        dynamicStates.push_back(true);
+
+    std::vector<bool> inputStates { false };
+
+    if (args.containsOption("--silence"))
+        inputStates.push_back(true);
+
+    std::vector<bool> parallelStates { false };
+    std::vector<bool> smoothingStates { false };
+
+    // smoothing cuts ramping spans into short calls that stay serial, so the parallel runs cover both
+    if (args.containsOption("--parallel"))
+        parallelStates.push_back(true);
+
+    if (args.containsOption("--smoothing") || args.containsOption("--parallel"))
+        smoothingStates.push_back(true);
+
+    std::vector<StereoMode> stereoModes { StereoMode::Linked };
+
+    if (args.containsOption("--stereo"))
+    {
+        stereoModes.clear();
+
+        for (auto& token : juce::StringArray::fromTokens(args.getValueForOption("--stereo"), ",", {}))
+            stereoModes.push_back(token == "ms" ? StereoMode::MidSide : token == "lr" ? StereoMode::LeftRight : StereoMode::Linked);
+    }
+
+    if (args.containsOption("--bands"))
+    {
+        bandCounts.clear();
+
+        for (auto& token : juce::StringArray::fromTokens(args.getValueForOption("--bands"), ",", {}))
+            bandCounts.push_back(juce::jlimit(0, maxBands, token.getIntValue()));
+    }
+
+    if (args.containsOption("--channels"))
+    {
+        channelCounts.clear();
+
+        for (auto& token : juce::StringArray::fromTokens(args.getValueForOption("--channels"), ",", {}))
+            channelCounts.push_back(juce::jlimit(1, SimpleEQAudioProcessor::maxNumChannels, token.getIntValue()));
+    }
+
+    if (quick)
+    {
+        blockSizes = { 64, 512 };
+        sampleRates = { 48000.0 };
+        automationIntervals = { 0, 1 };
+    }
+
+    std::cout << "engine,precision,phase,bands,dynamic,stereo,input,oversampling,analyzer,smoothing,parallel,channels,blockSize,sampleRate,slope,automationInterval,nsPerSample,p50Ms,p99Ms,maxMs,allocations,locks,idle" << std::endl;
+
+    int64_t totalAllocations = 0, totalUnsafeBlocks = 0;
+
+    std::vector<BenchmarkConfig> configs;
+
+    for (auto engine : engines)
+        for (auto precision : precisions)
+            for (auto linearPhase : phaseModes)
+                for (auto numBands : bandCounts)
+                    for (auto dynamic : dynamicStates)
+                        for (auto stereoMode : stereoModes)
+                            for (auto silentInput : inputStates)
+                                for (auto oversampling : oversamplingFactors)
+                                    for (auto analyzer : analyzerStates)
+                                        for (auto smoothing : smoothingStates)
+                                            for (auto parallel : parallelStates)
+                                                for (auto numChannels : channelCounts)
+                                                    for (auto sampleRate : sampleRates)
+                                                        for (auto blockSize : blockSizes)
+                                                            for (auto slope : slopes)
+                                                                for (auto automationInterval : automationIntervals)
+                                                                    configs.push_back({ blockSize, sampleRate, slope, automationInterval, engine,
+                                                                                        numChannels, analyzer, oversampling, linearPhase, precision,
+                                                                                        numBands, dynamic, stereoMode, silentInput, smoothing, parallel });
+
+    for (const auto& config : configs)
+    {
+        auto result = config.precision == Precision::Double ? runBenchmark<double>(config, secondsOfAudio)
+                                                            : runBenchmark<float>(config, secondsOfAudio);
+        totalAllocations += result.allocations;
+        totalUnsafeBlocks += result.unsafeBlocks;
+
+        std::cout << engineName(config.engine) << ","
+                  << precisionName(config.precision) << ","
+                  << (config.linearPhase ? "linear" : "minimum") << ","
+                  << config.numBands << ","
+                  << (config.dynamic ? "on" : "off") << ","
+                  << stereoModeName(config.stereoMode) << ","
+                  << (config.silentInput ? "silence" : "noise") << ","
+                  << (1 << config.oversampling) << "x,"
+                  << (config.analyzer ? "on" : "off") << ","
+                  << (config.smoothing ? "on" : "off") << ","
+                  << (config.parallel ? "on" : "off") << ","
+                  << config.numChannels << ","
+                  << config.blockSize << ","
+                  << config.sampleRate << ","
+                  << slopeName(config.slope) << ","
+                  << config.automationInterval << ","
+                  << juce::String(result.nsPerSample, 3) << ","
+                  << juce::String(result.p50Ms, 4) << ","
+                  << juce::String(result.p99Ms, 4) << ","
+                  << juce::String(result.maxMs, 4) << ","
+                  << result.allocations << ","
+                  << result.locks << ","
+                  << juce::String(result.idleBlocks, 3) << std::endl;
+    }
+
+    // processBlock is expected to be allocation (and with RealtimeChecks lock) free
+    return totalAllocations == 0 && totalUnsafeBlocks == 0 ? 0 : 1;
+}
@@ -0,0 +1,81 @@
+/*
+  ==============================================================================
+
+    BinaryState.h
+
+    Fixed layout plugin state: a 12 byte header (magic, format version,
+    number of values) followed by one little endian float per parameter,
+    in plain (denormalised) units so a changed parameter range keeps its
+    meaning. The parameter order is fixed by the processor; new parameters
+    are only ever appended, so any version reads the values it knows and
+    leaves the rest at their defaults. Decoding reads straight from the
+    host's memory, no parsing and no allocation.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+struct BinaryState
+{
+    static constexpr juce::uint32 magic = 0x53514553; // "SEQS"
+    static constexpr juce::uint32 version = 1;
+    static constexpr int headerSize = 3 * (int)sizeof(juce::uint32);
+
+    using Parameters = std::vector<juce::RangedAudioParameter*>;
+
+    static bool isBinaryState(const void* data, int sizeInBytes) noexcept
+    {
+        return data != nullptr && sizeInBytes >= headerSize && juce::ByteOrder::littleEndianInt(data) == magic;
+    }
+
+    static void write(juce::MemoryBlock& destData, const Parameters& parameters)
+    {
+        juce::MemoryOutputStream stream(destData, false);
+
+        stream.writeInt((int)magic);
+        stream.writeInt((int)version);
+        stream.writeInt((int)parameters.size());
+
+        for (auto* parameter : parameters)
+            stream.writeFloat(parameter->convertFrom0to1(parameter->getValue()));
+    }
+
+    // returns false (and changes nothing) if the data isn't a complete binary state
+    static bool read(const void* data, int sizeInBytes, const Parameters& parameters)
+    {
+        if (! isBinaryState(data, sizeInBytes))
+            return false;
+
+        const auto* bytes = static_cast<const char*>(data);
+        const auto formatVersion = juce::ByteOrder::littleEndianInt(bytes + 4);
+        const auto numValues = (int)juce::ByteOrder::littleEndianInt(bytes + 8);
+
+        if (formatVersion == 0 || numValues < 0 || numValues > (sizeInBytes - headerSize) / 4)
+            return false;
+
+        for (size_t i = 0; i < parameters.size(); ++i)
+        {
+            auto* parameter = parameters[i];
+            auto normalisedValue = parameter->getDefaultValue();
+
+            // an older state without this parameter, or a damaged value, leaves it at its default
+            if ((int)i < numValues)
+            {
+                const auto bits = juce::ByteOrder::littleEndianInt(bytes + headerSize + 4 * i);
+
+                float value;
+                std::memcpy(&value, &bits, sizeof(value));
+
+                if (std::isfinite(value))
+                    normalisedValue = parameter->convertTo0to1(value);
+            }
+
+            parameter->setValueNotifyingHost(normalisedValue);
+        }
+
+        return true;
+    }
+};
@@ -0,0 +1,63 @@
+/*
+  ==============================================================================
+
+    BiquadCascade.h
+
+    Transposed direct form II sections for FilterCascade, the same topology
+    and coefficient layout as juce::dsp::IIR::Filter.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "FilterCascade.h"
+
+// plain biquad coefficients, normalised so that a0 == 1 (same layout as juce::dsp::IIR::Coefficients).
+// Kept in double, the cascade rounds them to its own sample type.
+struct BiquadCoefficients
+{
+    double b0 { 1 }, b1 { 0 }, b2 { 0 }, a1 { 0 }, a2 { 0 };
+};
+
+struct BiquadSection
+{
+    using Coefficients = BiquadCoefficients;
+
+    static constexpr int numCoefficients = 5;
+    static constexpr int numStates = 2;
+
+    static std::array<double, numCoefficients> toArray(const BiquadCoefficients& c) noexcept
+    {
+        return { c.b0, c.b1, c.b2, c.a1, c.a2 };
+    }
+
+    template <typename SIMDType, typename SampleType>
+    static void process(const SIMDType* coefficients, SIMDType* state, SampleType* frames, int numFrames) noexcept
+    {
+        constexpr int numLanes = (int)SIMDType::SIMDNumElements;
+
+        const auto b0 = coefficients[0], b1 = coefficients[1], b2 = coefficients[2];
+        const auto a1 = coefficients[3], a2 = coefficients[4];
+        auto s1 = state[0], s2 = state[1];
+
+        for (int i = 0; i < numFrames; ++i)
+        {
+            auto* frame = frames + i * numLanes;
+
+            const auto in = SIMDType::fromRawArray(frame);
+            const auto out = b0 * in + s1;
+
+            s1 = b1 * in - a1 * out + s2;
+            s2 = b2 * in - a2 * out;
+
+            out.copyToRawArray(frame);
+        }
+
+        state[0] = s1;
+        state[1] = s2;
+    }
+};
+
+template <typename SampleType>
+using BiquadCascade = FilterCascade<SampleType, BiquadSection>;
@@ -0,0 +1,185 @@
+/*
+  ==============================================================================
+
+    DspLoadMeter.h
+
+    Cost of every processBlock call against its real-time budget (block
+    size / sample rate), measured with the high resolution tick counter.
+    The audio thread collects a histogram, the average and the worst block
+    over a window of windowSeconds of audio and publishes it at the end of
+    the window; the all-time worst block is tracked until reset. Readers on
+    any thread get a consistent copy of the last window through a seqlock,
+    like ChainSettingsSnapshot.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+struct DspLoadSnapshot
+{
+    // 10 % wide bins up to the full budget, the last one counts the blocks over budget
+    static constexpr int numBins = 11;
+
+    std::array<int, numBins> histogram {};
+    int numBlocks = 0;
+
+    // fractions of the budget, 1 == the whole block duration
+    float averageLoad = 0, windowWorstLoad = 0, worstLoad = 0;
+
+    juce::int64 numOverloads = 0; // blocks over budget since the last reset
+};
+
+class DspLoadMeter
+{
+public:
+    static constexpr double windowSeconds = 0.5;
+
+    void prepare(double newSampleRate) noexcept
+    {
+        sampleRate = newSampleRate;
+        secondsPerTick = 1.0 / (double)juce::Time::getHighResolutionTicksPerSecond();
+
+        window = DspLoadSnapshot();
+        windowLoadSum = 0.0;
+        windowSamples = 0;
+        resetWorstCase();
+    }
+
+    // times the enclosing scope as one block of numSamples
+    struct ScopedMeasurement
+    {
+        ScopedMeasurement(DspLoadMeter& meterToUse, int numSamplesInBlock) noexcept
+            : meter(meterToUse), numSamples(numSamplesInBlock), start(juce::Time::getHighResolutionTicks())
+        {
+        }
+
+        ~ScopedMeasurement() noexcept
+        {
+            meter.addBlock(juce::Time::getHighResolutionTicks() - start, numSamples);
+        }
+
+        DspLoadMeter& meter;
+        const int numSamples;
+        const juce::int64 start;
+    };
+
+    // audio thread
+    void addBlock(juce::int64 elapsedTicks, int numSamples) noexcept
+    {
+        if (numSamples <= 0 || sampleRate <= 0.0)
+            return;
+
+        if (worstCaseResetRequested.exchange(false, std::memory_order_acquire))
+        {
+            worstLoad = 0.f;
+            numOverloads = 0;
+        }
+
+        const auto load = (float)((double)elapsedTicks * secondsPerTick * sampleRate / numSamples);
+        const int bin = juce::jlimit(0, DspLoadSnapshot::numBins - 1, (int)(load * (DspLoadSnapshot::numBins - 1)));
+
+        ++window.histogram[(size_t)bin];
+        ++window.numBlocks;
+        window.windowWorstLoad = juce::jmax(window.windowWorstLoad, load);
+        worstLoad = juce::jmax(worstLoad, load);
+
+        if (load >= 1.f)
+            ++numOverloads;
+
+        windowLoadSum += load;
+        windowSamples += numSamples;
+
+        if (windowSamples >= windowSeconds * sampleRate)
+        {
+            window.averageLoad = (float)(windowLoadSum / window.numBlocks);
+            window.worstLoad = worstLoad;
+            window.numOverloads = numOverloads;
+
+            publish(window);
+
+            window = DspLoadSnapshot();
+            windowLoadSum = 0.0;
+            windowSamples = 0;
+        }
+    }
+
+    // any thread, e.g. the editor or a host-side tool
+    void resetWorstCase() noexcept { worstCaseResetRequested.store(true, std::memory_order_release); }
+
+    // any thread: the last complete window, retries while the audio thread is publishing
+    DspLoadSnapshot getSnapshot() const noexcept
+    {
+        for (;;)
+        {
+            const auto before = sequence.load(std::memory_order_acquire);
+
+            if ((before & 1) == 0)
+            {
+                DspLoadSnapshot snapshot;
+
+                for (size_t i = 0; i < snapshot.histogram.size(); ++i)
+                    snapshot.histogram[i] = published.histogram[i].load(std::memory_order_relaxed);
+
+                snapshot.numBlocks = published.numBlocks.load(std::memory_order_relaxed);
+                snapshot.averageLoad = published.averageLoad.load(std::memory_order_relaxed);
+                snapshot.windowWorstLoad = published.windowWorstLoad.load(std::memory_order_relaxed);
+                snapshot.worstLoad = published.worstLoad.load(std::memory_order_relaxed);
+                snapshot.numOverloads = published.numOverloads.load(std::memory_order_relaxed);
+
+                std::atomic_thread_fence(std::memory_order_acquire);
+
+                if (sequence.load(std::memory_order_relaxed) == before)
+                    return snapshot;
+            }
+
+            juce::Thread::yield();
+        }
+    }
+
+    // changes every time a new window is published
+    uint32_t getVersion() const noexcept { return sequence.load(std::memory_order_acquire); }
+
+private:
+    void publish(const DspLoadSnapshot& snapshot) noexcept
+    {
+        const auto start = sequence.load(std::memory_order_relaxed);
+
+        sequence.store(start + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (size_t i = 0; i < snapshot.histogram.size(); ++i)
+            published.histogram[i].store(snapshot.histogram[i], std::memory_order_relaxed);
+
+        published.numBlocks.store(snapshot.numBlocks, std::memory_order_relaxed);
+        published.averageLoad.store(snapshot.averageLoad, std::memory_order_relaxed);
+        published.windowWorstLoad.store(snapshot.windowWorstLoad, std::memory_order_relaxed);
+        published.worstLoad.store(snapshot.worstLoad, std::memory_order_relaxed);
+        published.numOverloads.store(snapshot.numOverloads, std::memory_order_relaxed);
+
+        sequence.store(start + 2, std::memory_order_release);
+    }
+
+    double sampleRate = 0.0, secondsPerTick = 0.0;
+
+    // audio thread only
+    DspLoadSnapshot window;
+    double windowLoadSum = 0.0;
+    int windowSamples = 0;
+    float worstLoad = 0.f;
+    juce::int64 numOverloads = 0;
+
+    struct PublishedSnapshot
+    {
+        std::array<std::atomic<int>, DspLoadSnapshot::numBins> histogram {};
+        std::atomic<int> numBlocks { 0 };
+        std::atomic<float> averageLoad { 0 }, windowWorstLoad { 0 }, worstLoad { 0 };
+        std::atomic<juce::int64> numOverloads { 0 };
+    };
+
+    PublishedSnapshot published;
+    std::atomic<uint32_t> sequence { 0 };
+    std::atomic<bool> worstCaseResetRequested { false };
+};
@@ -0,0 +1,208 @@
+/*
+  ==============================================================================
+
+    DynamicEq.h
+
+    Level detection for the bells in dynamic mode. Every dynamic band has
+    its own band-limited detector: a state variable band pass at the band's
+    frequency and quality on a mono mix of the input (or of the sidechain),
+    followed by an attack / release peak follower. Above the threshold the
+    detected level pulls the band's gain down by (1 - 1 / ratio) dB per dB,
+    like a compressor working on that band only.
+
+    The detectors run at the host rate over the whole block before the
+    cascades, leaving one gain per band and sub-block of subBlockSize
+    samples; the cascades redesign the dynamic bells from those while they
+    process, so the band gains move at most every subBlockSize samples.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+class DynamicEq
+{
+public:
+    static constexpr int subBlockSize = 32; // host samples per gain update
+
+    struct BandParameters
+    {
+        double frequency { 1000 }, quality { 1 };
+        float thresholdInDecibel { 0 }, ratio { 1 }, attackMs { 10 }, releaseMs { 100 };
+    };
+
+    // allocates, call it from prepareToPlay
+    void prepare(double newSampleRate, int maximumBlockSize, int numBandsToUse)
+    {
+        sampleRate = newSampleRate;
+        numBands = numBandsToUse;
+        maxSubBlocks = maximumBlockSize / subBlockSize + 1;
+
+        bands.assign((size_t)numBands, Band());
+        dynamicBands.assign((size_t)numBands, 0);
+        gainOffsets.assign((size_t)(maxSubBlocks * numBands), 0.f);
+        numDynamicBands = 0;
+        numProcessedSubBlocks = 0;
+    }
+
+    // clears the detectors, e.g. after a transport jump
+    void reset() noexcept
+    {
+        for (auto& band : bands)
+            band.ic1eq = band.ic2eq = band.envelope = 0.0;
+
+        std::fill(gainOffsets.begin(), gainOffsets.end(), 0.f);
+    }
+
+    // turns the detector of a band on with the given parameters, or off with nullptr
+    void setBand(int index, const BandParameters* parameters) noexcept
+    {
+        jassert(juce::isPositiveAndBelow(index, numBands));
+
+        auto& band = bands[(size_t)index];
+        const bool wasDynamic = band.isDynamic;
+
+        band.isDynamic = parameters != nullptr;
+
+        if (band.isDynamic)
+        {
+            const double frequency = juce::jlimit(10.0, 0.49 * sampleRate, parameters->frequency);
+            const double g = std::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+
+            band.k = 1.0 / parameters->quality;
+            band.a1 = 1.0 / (1.0 + g * (g + band.k));
+            band.a2 = g * band.a1;
+            band.a3 = g * band.a2;
+
+            band.attack = getFollowerCoefficient(parameters->attackMs);
+            band.release = getFollowerCoefficient(parameters->releaseMs);
+            band.threshold = parameters->thresholdInDecibel;
+            band.slope = 1.f - 1.f / juce::jmax(1.f, parameters->ratio);
+        }
+
+        // a detector coming back starts from silence instead of a stale level
+        if (band.isDynamic && ! wasDynamic)
+            band.ic1eq = band.ic2eq = band.envelope = 0.0;
+
+        // and a band turned off leaves no reduction behind
+        if (! band.isDynamic)
+            for (int subBlock = 0; subBlock < maxSubBlocks; ++subBlock)
+                gainOffsets[(size_t)(subBlock * numBands + index)] = 0.f;
+
+        numDynamicBands = 0;
+
+        for (int i = 0; i < numBands; ++i)
+            if (bands[(size_t)i].isDynamic)
+                dynamicBands[(size_t)numDynamicBands++] = i;
+    }
+
+    bool hasDynamicBands() const noexcept { return numDynamicBands > 0; }
+
+    // detector pass over one host block
+    template <typename SampleType>
+    void process(const SampleType* const* channels, int numChannels, int numSamples) noexcept
+    {
+        numProcessedSubBlocks = 0;
+
+        if (numDynamicBands == 0)
+            return;
+
+        double mono[subBlockSize];
+        const double channelGain = numChannels > 0 ? 1.0 / numChannels : 0.0;
+
+        for (int offset = 0; offset < numSamples; offset += subBlockSize)
+        {
+            const int numSubBlockSamples = juce::jmin(subBlockSize, numSamples - offset);
+
+            for (int i = 0; i < numSubBlockSamples; ++i)
+            {
+                double sum = 0.0;
+
+                for (int ch = 0; ch < numChannels; ++ch)
+                    sum += (double)channels[ch][offset + i];
+
+                mono[i] = sum * channelGain;
+            }
+
+            // blocks longer than announced in prepare keep updating the last row
+            auto* gains = gainOffsets.data() + juce::jmin(numProcessedSubBlocks, maxSubBlocks - 1) * numBands;
+
+            for (int i = 0; i < numDynamicBands; ++i)
+            {
+                const int index = dynamicBands[(size_t)i];
+                gains[index] = detect(bands[(size_t)index], mono, numSubBlockSamples);
+            }
+
+            numProcessedSubBlocks = juce::jmin(numProcessedSubBlocks + 1, maxSubBlocks);
+        }
+    }
+
+    // dB to add to the band's own gain in the given sub-block of the last block, 0 or below
+    float getGainOffset(int subBlock, int band) const noexcept
+    {
+        if (numProcessedSubBlocks == 0)
+            return 0.f;
+
+        subBlock = juce::jlimit(0, numProcessedSubBlocks - 1, subBlock);
+        return gainOffsets[(size_t)(subBlock * numBands + band)];
+    }
+
+private:
+    struct Band
+    {
+        bool isDynamic = false;
+        double a1 = 1, a2 = 0, a3 = 0, k = 1;
+        double ic1eq = 0, ic2eq = 0, envelope = 0;
+        double attack = 0, release = 0;
+        float threshold = 0, slope = 0;
+    };
+
+    double getFollowerCoefficient(float timeMs) const noexcept
+    {
+        return std::exp(-1.0 / (juce::jmax(0.01, (double)timeMs) * 0.001 * sampleRate));
+    }
+
+    static float detect(Band& band, const double* samples, int numSamples) noexcept
+    {
+        double ic1eq = band.ic1eq, ic2eq = band.ic2eq, envelope = band.envelope;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            // unity gain band pass, k * v1
+            const double v3 = samples[i] - ic2eq;
+            const double v1 = band.a1 * ic1eq + band.a2 * v3;
+            const double v2 = ic2eq + band.a2 * ic1eq + band.a3 * v3;
+
+            ic1eq = 2.0 * v1 - ic1eq;
+            ic2eq = 2.0 * v2 - ic2eq;
+
+            const double level = std::abs(band.k * v1);
+            const double coefficient = level > envelope ? band.attack : band.release;
+
+            envelope = level + coefficient * (envelope - level);
+        }
+
+        band.ic1eq = ic1eq;
+        band.ic2eq = ic2eq;
+        band.envelope = envelope;
+
+        const float over = juce::Decibels::gainToDecibels((float)envelope) - band.threshold;
+
+        return over > 0.f ? -over * band.slope : 0.f;
+    }
+
+    double sampleRate = 44100.0;
+    int numBands = 0, maxSubBlocks = 1;
+
+    std::vector<Band> bands;
+    std::vector<int> dynamicBands; // indices of the dynamic bands, compacted
+    int numDynamicBands = 0;
+
+    // one row of numBands gain offsets per sub-block of the last block
+    std::vector<float> gainOffsets;
+    int numProcessedSubBlocks = 0;
+
+    JUCE_LEAK_DETECTOR(DynamicEq)
+};
@@ -0,0 +1,313 @@
+/*
+  ==============================================================================
+
+    FilterCascade.h
+
+    The low cut / bands / high cut cascade (4 + 16 + 4 second order sections)
+    processed for several channels at once, one channel per SIMD lane.
+    Coefficients and filter state are kept as structure-of-arrays so a whole
+    lane group is loaded with a single register load. The section topology
+    (biquad, state variable filter) is a template parameter, see
+    BiquadCascade.h and SvfCascade.h.
+
+    Only the active sections are processed: the cut loops are instantiated
+    at compile time for every combination of cut depths, and the enabled
+    bands are compacted into a list of section indices, so the cost scales
+    with the active sections and the sample loop never checks bypass flags.
+
+    In mid / side mode the first two lanes carry mid and side instead of
+    left and right: the encoding is done while interleaving and the decoding
+    while deinterleaving, so it costs no extra pass over the buffers.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*  SectionType provides:
+        using Coefficients = ...;                 // design output for one section
+        static constexpr int numCoefficients;     // per lane
+        static constexpr int numStates;           // per lane
+        static std::array<double, numCoefficients> toArray(const Coefficients&);
+        static void process(const SIMDType* coefficients, SIMDType* state, SampleType* frames, int numFrames);
+*/
+template <typename SampleType, typename SectionType>
+class FilterCascade
+{
+public:
+    using SIMDType = juce::dsp::SIMDRegister<SampleType>;
+
+    static constexpr int numLanes = (int)SIMDType::SIMDNumElements;
+
+    static constexpr int maxBands = 16;
+
+    enum Sections
+    {
+        FirstLowCut = 0,
+        FirstBand = 4,
+        FirstHighCut = FirstBand + maxBands,
+        NumSections = FirstHighCut + 4
+    };
+
+    using Coefficients = typename SectionType::Coefficients;
+
+    FilterCascade()
+    {
+        for (int section = 0; section < NumSections; ++section)
+            setCoefficients(section, Coefficients());
+
+        reset();
+    }
+
+    // numLowCutSections / numHighCutSections: 0 (cut disabled) to 4 (48 dB/Oct),
+    // activeBands: indices of the bands to run, in processing order
+    void setActiveSections(int numLowCutSections, const int* activeBands, int numActiveBands, int numHighCutSections) noexcept
+    {
+        jassert(numLowCutSections >= 0 && numLowCutSections <= 4);
+        jassert(numHighCutSections >= 0 && numHighCutSections <= 4);
+        jassert(numActiveBands >= 0 && numActiveBands <= maxBands);
+
+        bool nowActive[NumSections] {};
+
+        for (int i = 0; i < numLowCutSections; ++i)
+            nowActive[FirstLowCut + i] = true;
+
+        for (int i = 0; i < numActiveBands; ++i)
+        {
+            jassert(juce::isPositiveAndBelow(activeBands[i], maxBands));
+
+            bandSections[i] = FirstBand + activeBands[i];
+            nowActive[bandSections[i]] = true;
+        }
+
+        for (int i = 0; i < numHighCutSections; ++i)
+            nowActive[FirstHighCut + i] = true;
+
+        // sections coming out of bypass start from silence instead of stale state
+        for (int section = 0; section < NumSections; ++section)
+        {
+            if (nowActive[section] && ! isActive[section])
+                clearState(section);
+
+            isActive[section] = nowActive[section];
+        }
+
+        numBandSections = numActiveBands;
+        numActiveSections = numLowCutSections + numActiveBands + numHighCutSections;
+        processChunk = selectChunkProcessor(numLowCutSections, numHighCutSections);
+    }
+
+    // lanes 0 and 1 run mid and side instead of the first two channels, the state is cleared on a change
+    void setMidSide(bool shouldUseMidSide) noexcept
+    {
+        if (shouldUseMidSide != isMidSide)
+            reset();
+
+        isMidSide = shouldUseMidSide;
+    }
+
+    // clears the filter state of every lane
+    void reset() noexcept
+    {
+        for (int section = 0; section < NumSections; ++section)
+            clearState(section);
+
+        std::fill(scratch, scratch + maxChunkSize * numLanes, SampleType(0));
+    }
+
+    void setCoefficients(int section, int lane, const Coefficients& c) noexcept
+    {
+        jassert(juce::isPositiveAndBelow(section, (int)NumSections));
+        jassert(juce::isPositiveAndBelow(lane, numLanes));
+
+        const auto values = SectionType::toArray(c);
+
+        for (int i = 0; i < numCoefficients; ++i)
+            coefficients[section][i][lane] = (SampleType)values[i];
+    }
+
+    // same coefficients for every lane
+    void setCoefficients(int section, const Coefficients& c) noexcept
+    {
+        for (int lane = 0; lane < numLanes; ++lane)
+            setCoefficients(section, lane, c);
+    }
+
+    // processes up to numLanes channels in place
+    void process(SampleType* const* channels, int numChannels, int numSamples) noexcept
+    {
+        jassert(numChannels <= numLanes);
+
+        // every section bypassed, the signal passes through untouched
+        if (numActiveSections == 0)
+            return;
+
+        for (int offset = 0; offset < numSamples; offset += maxChunkSize)
+        {
+            const int numChunkSamples = juce::jmin(maxChunkSize, numSamples - offset);
+
+            interleave(channels, numChannels, offset, numChunkSamples);
+
+            (this->*processChunk)(numChunkSamples);
+
+            deinterleave(channels, numChannels, offset, numChunkSamples);
+        }
+    }
+
+private:
+    static constexpr int numCoefficients = SectionType::numCoefficients;
+    static constexpr int numStates = SectionType::numStates;
+    static constexpr int maxChunkSize = 32;
+
+    using ChunkProcessor = void (FilterCascade::*)(int) noexcept;
+
+    void clearState(int section) noexcept
+    {
+        std::fill(state[section][0], state[section][0] + numStates * numLanes, SampleType(0));
+    }
+
+    template <int numLowCut, int numHighCut>
+    void processChunkWith(int numChunkSamples) noexcept
+    {
+        processSections<FirstLowCut>(std::make_integer_sequence<int, numLowCut>(), numChunkSamples);
+
+        for (int i = 0; i < numBandSections; ++i)
+            processSection(bandSections[i], numChunkSamples);
+
+        processSections<FirstHighCut>(std::make_integer_sequence<int, numHighCut>(), numChunkSamples);
+    }
+
+    template <int firstSection, int... offsets>
+    void processSections(std::integer_sequence<int, offsets...>, int numChunkSamples) noexcept
+    {
+        (processSection(firstSection + offsets, numChunkSamples), ...);
+    }
+
+    template <int numLowCut>
+    static ChunkProcessor selectHighCut(int numHighCut) noexcept
+    {
+        switch (numHighCut)
+        {
+            case 1:  return &FilterCascade::processChunkWith<numLowCut, 1>;
+            case 2:  return &FilterCascade::processChunkWith<numLowCut, 2>;
+            case 3:  return &FilterCascade::processChunkWith<numLowCut, 3>;
+            case 4:  return &FilterCascade::processChunkWith<numLowCut, 4>;
+            default: return &FilterCascade::processChunkWith<numLowCut, 0>;
+        }
+    }
+
+    static ChunkProcessor selectChunkProcessor(int numLowCut, int numHighCut) noexcept
+    {
+        switch (numLowCut)
+        {
+            case 1:  return selectHighCut<1>(numHighCut);
+            case 2:  return selectHighCut<2>(numHighCut);
+            case 3:  return selectHighCut<3>(numHighCut);
+            case 4:  return selectHighCut<4>(numHighCut);
+            default: return selectHighCut<0>(numHighCut);
+        }
+    }
+
+    bool usesMidSide(int numChannels) const noexcept { return isMidSide && numLanes >= 2 && numChannels >= 2; }
+
+    void interleave(SampleType* const* channels, int numChannels, int offset, int numChunkSamples) noexcept
+    {
+        int firstLane = 0;
+
+        if (usesMidSide(numChannels))
+        {
+            const auto* left = channels[0] + offset;
+            const auto* right = channels[1] + offset;
+            const auto half = SampleType(0.5);
+
+            for (int i = 0; i < numChunkSamples; ++i)
+            {
+                scratch[i * numLanes] = half * (left[i] + right[i]);
+                scratch[i * numLanes + 1] = half * (left[i] - right[i]);
+            }
+
+            firstLane = 2;
+        }
+
+        for (int lane = firstLane; lane < numLanes; ++lane)
+        {
+            if (lane < numChannels)
+            {
+                const auto* source = channels[lane] + offset;
+
+                for (int i = 0; i < numChunkSamples; ++i)
+                    scratch[i * numLanes + lane] = source[i];
+            }
+            else
+            {
+                for (int i = 0; i < numChunkSamples; ++i)
+                    scratch[i * numLanes + lane] = SampleType(0);
+            }
+        }
+    }
+
+    void deinterleave(SampleType* const* channels, int numChannels, int offset, int numChunkSamples) const noexcept
+    {
+        int firstLane = 0;
+
+        if (usesMidSide(numChannels))
+        {
+            auto* left = channels[0] + offset;
+            auto* right = channels[1] + offset;
+
+            for (int i = 0; i < numChunkSamples; ++i)
+            {
+                const auto mid = scratch[i * numLanes];
+                const auto side = scratch[i * numLanes + 1];
+
+                left[i] = mid + side;
+                right[i] = mid - side;
+            }
+
+            firstLane = 2;
+        }
+
+        for (int lane = firstLane; lane < numChannels; ++lane)
+        {
+            auto* destination = channels[lane] + offset;
+
+            for (int i = 0; i < numChunkSamples; ++i)
+                destination[i] = scratch[i * numLanes + lane];
+        }
+    }
+
+    void processSection(int section, int numChunkSamples) noexcept
+    {
+        SIMDType sectionCoefficients[numCoefficients];
+        SIMDType sectionState[numStates];
+
+        for (int i = 0; i < numCoefficients; ++i)
+            sectionCoefficients[i] = SIMDType::fromRawArray(coefficients[section][i]);
+
+        for (int i = 0; i < numStates; ++i)
+            sectionState[i] = SIMDType::fromRawArray(state[section][i]);
+
+        SectionType::process(sectionCoefficients, sectionState, scratch, numChunkSamples);
+
+        for (int i = 0; i < numStates; ++i)
+            sectionState[i].copyToRawArray(state[section][i]);
+    }
+
+    alignas(SIMDType::SIMDRegisterSize) SampleType coefficients[NumSections][numCoefficients][numLanes];
+    alignas(SIMDType::SIMDRegisterSize) SampleType state[NumSections][numStates][numLanes];
+    alignas(SIMDType::SIMDRegisterSize) SampleType scratch[maxChunkSize * numLanes];
+
+    bool isActive[NumSections] {};
+    int numActiveSections = 0;
+    bool isMidSide = false;
+
+    // section index of every active band, compacted
+    int bandSections[maxBands] {};
+    int numBandSections = 0;
+
+    ChunkProcessor processChunk = &FilterCascade::processChunkWith<0, 0>;
+
+    JUCE_LEAK_DETECTOR(FilterCascade)
+};
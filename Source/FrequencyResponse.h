@@ -0,0 +1,220 @@
+/*
+  ==============================================================================
+
+    FrequencyResponse.h
+
+    Response of a set of second order sections evaluated over a whole
+    frequency table at once. Everything that only depends on the frequency
+    is computed once in prepare(); adding a section is then a few multiply /
+    add loops over contiguous arrays that the compiler vectorises across
+    frequencies, and the division and log10 happen once per frequency
+    instead of once per section as with getMagnitudeForFrequency.
+
+    The magnitude uses the sin^2(w / 2) form of |H|^2, which stays accurate
+    for cuts far below the sample rate where the cos(w) form cancels out.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "BiquadCascade.h"
+
+class FrequencyResponse
+{
+public:
+    enum Outputs
+    {
+        MagnitudeOnly = 0,
+        WithPhase = 1,
+        WithGroupDelay = 2
+    };
+
+    // frequencies in Hz; allocates, so call it when the table or the sample rate changes
+    void prepare(const double* frequencies, int numFrequencies, double sampleRate)
+    {
+        const auto size = (size_t)juce::jmax(0, numFrequencies);
+
+        for (auto* table : { &phi, &cosW, &sinW, &cos2W, &sin2W, &numerator, &denominator, &phase, &groupDelay })
+            table->resize(size);
+
+        for (size_t i = 0; i < size; ++i)
+        {
+            const double w = sampleRate > 0.0 ? juce::MathConstants<double>::twoPi * frequencies[i] / sampleRate : 0.0;
+            const double sinHalfW = std::sin(0.5 * w);
+
+            phi[i] = sinHalfW * sinHalfW;
+            cosW[i] = std::cos(w);
+            sinW[i] = std::sin(w);
+            cos2W[i] = std::cos(2.0 * w);
+            sin2W[i] = std::sin(2.0 * w);
+        }
+
+        reset();
+    }
+
+    int getNumFrequencies() const noexcept { return (int)phi.size(); }
+
+    // starts a new response at unity gain and zero phase
+    void reset(int outputsToUse = MagnitudeOnly) noexcept
+    {
+        outputs = outputsToUse;
+
+        std::fill(numerator.begin(), numerator.end(), 1.0);
+        std::fill(denominator.begin(), denominator.end(), 1.0);
+        std::fill(phase.begin(), phase.end(), 0.0);
+        std::fill(groupDelay.begin(), groupDelay.end(), 0.0);
+    }
+
+    void addSection(const BiquadCoefficients& c) noexcept
+    {
+        addSection(c.b0, c.b1, c.b2, c.a1, c.a2);
+    }
+
+    void addSection(const juce::dsp::IIR::Coefficients<float>& c) noexcept
+    {
+        auto* raw = c.coefficients.begin();
+
+        // normalised first order sections are stored as b0, b1, a1
+        if (c.coefficients.size() == 3)
+            addSection(raw[0], raw[1], 0.0, raw[2], 0.0);
+        else if (c.coefficients.size() == 5)
+            addSection(raw[0], raw[1], raw[2], raw[3], raw[4]);
+        else
+            jassertfalse; // only first and second order sections are supported
+    }
+
+    void addSections(const BiquadCoefficients* sections, int numSections) noexcept
+    {
+        for (int i = 0; i < numSections; ++i)
+            addSection(sections[i]);
+    }
+
+    void addSections(const juce::ReferenceCountedArray<juce::dsp::IIR::Coefficients<float>>& sections) noexcept
+    {
+        for (auto* section : sections)
+            if (section != nullptr)
+                addSection(*section);
+    }
+
+    // minimumDecibels matches the floor of juce::Decibels::gainToDecibels
+    void getMagnitudesInDecibels(double* destination, double minimumDecibels = -100.0) const noexcept
+    {
+        const double minimumPower = std::pow(10.0, minimumDecibels / 10.0);
+
+        for (size_t i = 0; i < phi.size(); ++i)
+            destination[i] = 10.0 * std::log10(juce::jmax(minimumPower, numerator[i] / denominator[i]));
+    }
+
+    void getMagnitudes(double* destination) const noexcept
+    {
+        for (size_t i = 0; i < phi.size(); ++i)
+            destination[i] = std::sqrt(numerator[i] / denominator[i]);
+    }
+
+    // phase in radians as the sum of every section's own phase, each wrapped to (-pi, pi]: the sum is
+    // neither wrapped nor continuous across frequency. Needs WithPhase.
+    const std::vector<double>& getPhases() const noexcept
+    {
+        jassert((outputs & WithPhase) != 0);
+        return phase;
+    }
+
+    // phase in radians made continuous across the frequency table (which has to be in ascending order),
+    // starting from the wrapped value at the first frequency. Needs WithPhase.
+    void getUnwrappedPhases(double* destination) const noexcept
+    {
+        jassert((outputs & WithPhase) != 0);
+
+        const double twoPi = juce::MathConstants<double>::twoPi;
+        double offset = 0.0;
+
+        for (size_t i = 0; i < phase.size(); ++i)
+        {
+            if (i == 0)
+            {
+                offset = std::remainder(phase[0], twoPi) - phase[0];
+            }
+            else
+            {
+                // jumps of more than pi between neighbouring frequencies are taken as wraps
+                const double step = phase[i] + offset - destination[i - 1];
+                offset -= twoPi * std::round(step / twoPi);
+            }
+
+            destination[i] = phase[i] + offset;
+        }
+    }
+
+    // group delay in samples, needs WithGroupDelay
+    const std::vector<double>& getGroupDelays() const noexcept
+    {
+        jassert((outputs & WithGroupDelay) != 0);
+        return groupDelay;
+    }
+
+private:
+    void addSection(double b0, double b1, double b2, double a1, double a2) noexcept
+    {
+        const auto numFrequencies = phi.size();
+
+        // |p0 + p1 z^-1 + p2 z^-2|^2 = (p0 + p1 + p2)^2 - 4 (p0 p1 + 4 p0 p2 + p1 p2) phi + 16 p0 p2 phi^2
+        const double n0 = (b0 + b1 + b2) * (b0 + b1 + b2);
+        const double n1 = -4.0 * (b0 * b1 + 4.0 * b0 * b2 + b1 * b2);
+        const double n2 = 16.0 * b0 * b2;
+
+        const double d0 = (1.0 + a1 + a2) * (1.0 + a1 + a2);
+        const double d1 = -4.0 * (a1 + 4.0 * a2 + a1 * a2);
+        const double d2 = 16.0 * a2;
+
+        auto* num = numerator.data();
+        auto* den = denominator.data();
+        const auto* p = phi.data();
+
+        for (size_t i = 0; i < numFrequencies; ++i)
+        {
+            num[i] *= n0 + p[i] * (n1 + p[i] * n2);
+            den[i] *= d0 + p[i] * (d1 + p[i] * d2);
+        }
+
+        if ((outputs & (WithPhase | WithGroupDelay)) == 0)
+            return;
+
+        for (size_t i = 0; i < numFrequencies; ++i)
+        {
+            // real and imaginary part of the polynomials and of their derivative terms sum(k * p_k * z^-k)
+            const double nr = b0 + b1 * cosW[i] + b2 * cos2W[i];
+            const double ni = -(b1 * sinW[i] + b2 * sin2W[i]);
+            const double dr = 1.0 + a1 * cosW[i] + a2 * cos2W[i];
+            const double di = -(a1 * sinW[i] + a2 * sin2W[i]);
+
+            if ((outputs & WithPhase) != 0)
+                phase[i] += std::atan2(ni, nr) - std::atan2(di, dr);
+
+            if ((outputs & WithGroupDelay) != 0)
+            {
+                const double nkr = b1 * cosW[i] + 2.0 * b2 * cos2W[i];
+                const double nki = -(b1 * sinW[i] + 2.0 * b2 * sin2W[i]);
+                const double dkr = a1 * cosW[i] + 2.0 * a2 * cos2W[i];
+                const double dki = -(a1 * sinW[i] + 2.0 * a2 * sin2W[i]);
+
+                const double nPower = nr * nr + ni * ni;
+                const double dPower = dr * dr + di * di;
+
+                groupDelay[i] += (nPower > 0.0 ? (nkr * nr + nki * ni) / nPower : 0.0)
+                               - (dkr * dr + dki * di) / dPower;
+            }
+        }
+    }
+
+    int outputs = MagnitudeOnly;
+
+    // per frequency: sin^2(w / 2) and the terms for phase and group delay
+    std::vector<double> phi, cosW, sinW, cos2W, sin2W;
+
+    // accumulated |numerator|^2 and |denominator|^2 over all added sections
+    std::vector<double> numerator, denominator;
+    std::vector<double> phase, groupDelay;
+
+    JUCE_LEAK_DETECTOR(FrequencyResponse)
+};
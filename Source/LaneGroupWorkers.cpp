@@ -0,0 +1,394 @@
+/*
+  ==============================================================================
+
+    LaneGroupWorkers.cpp
+
+    The worker threads and their wait / wake-up behind LaneGroupWorkers.h.
+
+  ==============================================================================
+*/
+
+#include "LaneGroupWorkers.h"
+
+#if JUCE_LINUX || JUCE_ANDROID
+ #define SIMPLEEQ_WORKERS_USE_FUTEX 1
+ #include <climits>
+ #include <linux/futex.h>
+ #include <sys/syscall.h>
+ #include <unistd.h>
+#else
+ #define SIMPLEEQ_WORKERS_USE_FUTEX 0
+#endif
+
+#if JUCE_INTEL
+ #include <immintrin.h>
+#endif
+
+namespace
+{
+    // one spin-wait iteration, without giving up the core
+    inline void spinPause() noexcept
+    {
+       #if JUCE_INTEL
+        _mm_pause();
+       #elif JUCE_ARM && ! JUCE_MSVC
+        __asm__ __volatile__ ("yield");
+       #else
+        std::this_thread::yield();
+       #endif
+    }
+}
+
+//==============================================================================
+struct LaneGroupWorkers::Worker : juce::Thread
+{
+    Worker(LaneGroupWorkers& ownerToUse, int index)
+        : juce::Thread("SimpleEQ Lane Group Worker " + juce::String(index)), owner(ownerToUse)
+    {
+    }
+
+    void run() override { owner.workerLoop(*this); }
+
+    LaneGroupWorkers& owner;
+    std::atomic<Job*> hazard { nullptr }; // the job this worker is inside, detach waits for it
+    juce::WaitableEvent wakeEvent;        // without futex
+};
+
+//==============================================================================
+LaneGroupWorkers::~LaneGroupWorkers()
+{
+    // every processor detaches before it lets go of the pool
+    jassert(numJobSlots.load() == 0);
+
+    stop();
+}
+
+bool LaneGroupWorkers::attach(Job& job)
+{
+    const juce::ScopedLock sl(lock);
+
+    if (job.slot >= 0)
+        return true;
+
+    if (workers.empty())
+        start();
+
+    if (workers.empty())
+        return false;
+
+    for (int slot = 0; slot < maxJobs; ++slot)
+    {
+        if (jobs[(size_t)slot].load() == nullptr)
+        {
+            for (auto& state : job.states)
+                state.store(Job::makeState(0, Job::Idle));
+
+            job.lastGeneration = 0;
+            job.slot = slot;
+            jobs[(size_t)slot].store(&job);
+
+            if (slot >= numJobSlots.load())
+                numJobSlots.store(slot + 1);
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void LaneGroupWorkers::detach(Job& job)
+{
+    const juce::ScopedLock sl(lock);
+
+    if (job.slot < 0)
+        return;
+
+    jobs[(size_t)job.slot].store(nullptr);
+    job.slot = -1;
+
+    // a worker that took the job before it left the slot may still be on an abandoned copy
+    for (auto& worker : workers)
+        while (worker->hazard.load() == &job)
+            juce::Thread::yield();
+
+    int numSlots = numJobSlots.load();
+
+    while (numSlots > 0 && jobs[(size_t)numSlots - 1].load() == nullptr)
+        --numSlots;
+
+    numJobSlots.store(numSlots);
+}
+
+void LaneGroupWorkers::start()
+{
+    stopping.store(false);
+
+    const int numWorkers = juce::jmin(maxWorkers, juce::SystemStats::getNumCpus() - 1);
+
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        workers.push_back(std::make_unique<Worker>(*this, i));
+
+        // they run part of the audio callback, so they are scheduled like it where the system allows
+       #if JUCE_VERSION >= 0x70003
+        if (! workers.back()->startRealtimeThread(juce::Thread::RealtimeOptions {}))
+            workers.back()->startThread(juce::Thread::Priority::highest);
+       #else
+        workers.back()->startThread(10);
+       #endif
+    }
+}
+
+void LaneGroupWorkers::stop()
+{
+    if (workers.empty())
+        return;
+
+    stopping.store(true);
+
+    for (auto& worker : workers)
+        worker->signalThreadShouldExit();
+
+    wakeCount.fetch_add(1);
+    wakeWorkers((int)workers.size());
+
+    for (auto& worker : workers)
+        worker->stopThread(1000);
+
+    workers.clear();
+}
+
+//==============================================================================
+void LaneGroupWorkers::run(Job& job, Task task, void* context, void* copies, int numTasks) noexcept
+{
+    jassert(numTasks <= maxTasks);
+    numTasks = juce::jmin(numTasks, maxTasks);
+
+    // a detached job works as well, its offered tasks just all come back to the caller
+    if (numTasks < 2)
+    {
+        for (int i = 0; i < numTasks; ++i)
+            task(context, copies, i, Stage::InPlace);
+
+        return;
+    }
+
+    const auto generation = ++job.lastGeneration & 0x1fffffff;
+    const auto open = Job::makeState(generation, Job::Open);
+    const auto onWorker = Job::makeState(generation, Job::OnWorker);
+    const auto done = Job::makeState(generation, Job::Done);
+
+    job.task.store(task, std::memory_order_relaxed);
+    job.context.store(context, std::memory_order_relaxed);
+    job.copies.store(copies, std::memory_order_relaxed);
+
+    // tasks whose copy a late worker still has stay here, the others are copied out and offered
+    bool isOnCaller[maxTasks] { true };
+    int numOffered = 0;
+
+    for (int i = 1; i < numTasks; ++i)
+    {
+        auto& state = job.states[(size_t)i];
+        isOnCaller[i] = Job::getState(state.load(std::memory_order_acquire)) == Job::Abandoned;
+
+        if (! isOnCaller[i])
+        {
+            task(context, copies, i, Stage::ToCopy);
+            state.store(open, std::memory_order_release);
+            ++numOffered;
+        }
+    }
+
+    if (numOffered > 0)
+    {
+        // either a worker going to sleep sees the new count, or we see it sleeping
+        wakeCount.fetch_add(1);
+
+        if (numSleeping.load() > 0)
+            wakeWorkers(numOffered);
+    }
+
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+    int numOwnTasks = 0;
+
+    for (int i = 0; i < numTasks; ++i)
+    {
+        if (isOnCaller[i])
+        {
+            task(context, copies, i, Stage::InPlace);
+            ++numOwnTasks;
+        }
+    }
+
+    // whatever no worker has claimed by now runs here as well
+    for (int i = 1; i < numTasks; ++i)
+    {
+        auto expected = open;
+
+        if (! isOnCaller[i] && job.states[(size_t)i].compare_exchange_strong(expected, Job::makeState(generation, Job::OnCaller),
+                                                                          std::memory_order_acquire))
+        {
+            isOnCaller[i] = true;
+            task(context, copies, i, Stage::InPlace);
+            ++numOwnTasks;
+        }
+    }
+
+    // a worker that started with us should be done within about one task's time
+    const auto taskTicks = (juce::Time::getHighResolutionTicks() - startTicks) / juce::jmax(1, numOwnTasks);
+    const auto deadline = juce::Time::getHighResolutionTicks()
+                        + juce::jmax(taskTicks, juce::Time::secondsToHighResolutionTicks(minWaitMicroseconds * 1.0e-6));
+
+    int numPending = 0;
+
+    for (int i = 1; i < numTasks; ++i)
+        numPending += isOnCaller[i] ? 0 : 1;
+
+    while (numPending > 0)
+    {
+        const bool isLate = juce::Time::getHighResolutionTicks() > deadline;
+
+        for (int i = 1; i < numTasks; ++i)
+        {
+            if (isOnCaller[i])
+                continue;
+
+            auto& state = job.states[(size_t)i];
+            auto current = state.load(std::memory_order_acquire);
+
+            if (current == done)
+            {
+                task(context, copies, i, Stage::FromCopy);
+            }
+            else if (isLate && current == onWorker
+                     && state.compare_exchange_strong(current, Job::makeState(generation, Job::Abandoned), std::memory_order_acquire))
+            {
+                // the worker finishes on its copy, which the next runs leave alone until it is done
+                task(context, copies, i, Stage::InPlace);
+            }
+            else
+            {
+                continue;
+            }
+
+            isOnCaller[i] = true;
+            --numPending;
+        }
+
+        if (numPending > 0)
+            spinPause();
+    }
+}
+
+//==============================================================================
+void LaneGroupWorkers::workerLoop(Worker& worker)
+{
+    // the cascades expect flush-to-zero, like the audio thread has it inside processBlock
+    juce::FloatVectorOperations::disableDenormalisedNumberSupport();
+
+    for (;;)
+    {
+        const auto seenWakeCount = wakeCount.load();
+
+        if (stopping.load() || worker.threadShouldExit())
+            return;
+
+        if (! runOpenTasks(worker))
+            waitForWork(worker, seenWakeCount);
+    }
+}
+
+bool LaneGroupWorkers::runOpenTasks(Worker& worker) noexcept
+{
+    bool ranAny = false;
+    const int numSlots = numJobSlots.load(std::memory_order_acquire);
+
+    for (int slot = 0; slot < numSlots; ++slot)
+    {
+        auto* job = jobs[(size_t)slot].load(std::memory_order_acquire);
+
+        if (job == nullptr)
+            continue;
+
+        // announce the job before using it, detach checks for it after clearing the slot
+        worker.hazard.store(job);
+
+        if (jobs[(size_t)slot].load() == job)
+        {
+            for (auto& state : job->states)
+            {
+                auto current = state.load(std::memory_order_acquire);
+
+                if (Job::getState(current) != Job::Open)
+                    continue;
+
+                // read before the claim: if the claim succeeds the run they belong to is still going
+                auto* task = job->task.load(std::memory_order_relaxed);
+                auto* copies = job->copies.load(std::memory_order_relaxed);
+                auto* context = job->context.load(std::memory_order_relaxed);
+                const auto generation = current >> 3;
+                const auto onWorker = Job::makeState(generation, Job::OnWorker);
+
+                if (! state.compare_exchange_strong(current, onWorker, std::memory_order_acq_rel))
+                    continue;
+
+                task(context, copies, (int)(&state - job->states.data()), Stage::Process);
+                ranAny = true;
+
+                // the caller gave up on it and ran it itself: only free the copy
+                auto expected = onWorker;
+
+                if (! state.compare_exchange_strong(expected, Job::makeState(generation, Job::Done), std::memory_order_release))
+                    state.store(Job::makeState(generation, Job::Idle), std::memory_order_release);
+            }
+        }
+
+        worker.hazard.store(nullptr, std::memory_order_release);
+    }
+
+    return ranAny;
+}
+
+void LaneGroupWorkers::waitForWork(Worker& worker, juce::uint32 seenWakeCount) noexcept
+{
+    const auto spinEnd = juce::Time::getHighResolutionTicks() + juce::Time::secondsToHighResolutionTicks(spinMicroseconds * 1.0e-6);
+
+    while (wakeCount.load(std::memory_order_acquire) == seenWakeCount)
+    {
+        if (juce::Time::getHighResolutionTicks() < spinEnd)
+        {
+            spinPause();
+            continue;
+        }
+
+        numSleeping.fetch_add(1);
+
+        if (wakeCount.load() == seenWakeCount)
+        {
+           #if SIMPLEEQ_WORKERS_USE_FUTEX
+            // returns right away if the count moved on in the meantime
+            syscall(SYS_futex, reinterpret_cast<juce::uint32*>(&wakeCount), FUTEX_WAIT_PRIVATE, seenWakeCount, nullptr, nullptr, 0);
+           #else
+            worker.wakeEvent.wait(10);
+           #endif
+        }
+
+        numSleeping.fetch_sub(1);
+    }
+
+    juce::ignoreUnused(worker);
+}
+
+void LaneGroupWorkers::wakeWorkers(int numToWake) noexcept
+{
+   #if SIMPLEEQ_WORKERS_USE_FUTEX
+    syscall(SYS_futex, reinterpret_cast<juce::uint32*>(&wakeCount), FUTEX_WAKE_PRIVATE, numToWake, nullptr, nullptr, 0);
+   #else
+    // which ones sleep isn't known, the others time out of their wait soon enough
+    juce::ignoreUnused(numToWake);
+
+    for (auto& worker : workers)
+        worker->wakeEvent.signal();
+   #endif
+}
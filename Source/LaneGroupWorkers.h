@@ -0,0 +1,120 @@
+/*
+  ==============================================================================
+
+    LaneGroupWorkers.h
+
+    One pool of real-time worker threads per process, shared by every
+    processor through a juce::SharedResourcePointer, that helps the audio
+    threads through the lane groups of wide buses. Each processor attaches
+    a Job; run() keeps task 0 for the calling thread and offers the others
+    to the workers. Nothing in run() allocates or locks.
+
+    A worker never touches the caller's buffers: the task's state and input
+    are copied out before it is offered (Stage::ToCopy), the worker
+    processes the copy (Stage::Process) and the caller copies the result
+    back (Stage::FromCopy). So the caller's wait is bounded: a task no
+    worker has claimed by the time the caller is done with its own, or
+    that a worker hasn't finished one task's time later, the caller runs
+    in place itself (Stage::InPlace) and drops the worker's result. Until
+    that worker is done with the copy the task stays on the caller.
+
+    Each task's state word carries the generation of the run, so a worker
+    that wakes up late can never claim a task of an earlier run. Idle
+    workers spin for spinMicroseconds, then sleep; on Linux on a futex,
+    so waking them costs one system call without a lock, elsewhere on a
+    juce::WaitableEvent each. The workers ask for real-time scheduling but
+    don't join the host's audio workgroup, as the pool serves every
+    instance whatever device it runs on.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+class LaneGroupWorkers
+{
+public:
+    enum class Stage
+    {
+        InPlace,  // process the task on the caller's buffers
+        ToCopy,   // copy its state and input out, on the calling thread
+        Process,  // process the copy; may run on a worker after run() returned, so only touch the copy
+        FromCopy  // copy state and output back, on the calling thread
+    };
+
+    // context is only valid for the calling thread's stages, copies for all of them
+    using Task = void (*)(void* context, void* copies, int index, Stage stage);
+
+    static constexpr int maxWorkers = 7;
+    static constexpr int maxTasks = 8;
+    static constexpr int maxJobs = 128;
+    static constexpr int spinMicroseconds = 20;
+    static constexpr int minWaitMicroseconds = 20;
+
+    // one per processor, attached while it may run tasks in parallel
+    class Job
+    {
+    public:
+        Job() = default;
+        ~Job() { jassert(slot < 0); } // detach it first
+
+    private:
+        friend class LaneGroupWorkers;
+
+        enum TaskState : juce::uint32 { Idle, Open, OnWorker, OnCaller, Done, Abandoned };
+
+        static juce::uint32 makeState(juce::uint32 generation, TaskState state) noexcept { return generation << 3 | state; }
+        static TaskState getState(juce::uint32 word) noexcept { return (TaskState)(word & 7); }
+
+        std::atomic<Task> task { nullptr };
+        std::atomic<void*> context { nullptr };
+        std::atomic<void*> copies { nullptr };
+        std::array<std::atomic<juce::uint32>, maxTasks> states {};
+
+        juce::uint32 lastGeneration = 0; // calling thread only
+        int slot = -1;                   // under the pool's lock
+
+        JUCE_DECLARE_NON_COPYABLE(Job)
+    };
+
+    LaneGroupWorkers() = default;
+    ~LaneGroupWorkers();
+
+    // starts the workers on first use and makes the job's tasks visible to them. Allocates, never call it
+    // from the audio thread. Returns false if there are no workers (a single core) or no free slot.
+    bool attach(Job& job);
+
+    // returns once no worker is inside the job any more, so its copies can go; not while run() may be called
+    void detach(Job& job);
+
+    int getNumWorkers() const noexcept { return (int)workers.size(); }
+
+    // runs every index below numTasks (up to maxTasks), on the calling thread and the workers
+    void run(Job& job, Task task, void* context, void* copies, int numTasks) noexcept;
+
+private:
+    struct Worker;
+
+    void workerLoop(Worker& worker);
+    bool runOpenTasks(Worker& worker) noexcept;
+
+    void waitForWork(Worker& worker, juce::uint32 seenWakeCount) noexcept;
+    void wakeWorkers(int numToWake) noexcept;
+
+    void start();
+    void stop();
+
+    std::array<std::atomic<Job*>, maxJobs> jobs {};
+    std::atomic<int> numJobSlots { 0 }; // highest slot in use + 1
+
+    std::atomic<juce::uint32> wakeCount { 0 }; // what idle workers wait on
+    std::atomic<int> numSleeping { 0 };
+    std::atomic<bool> stopping { false };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    juce::CriticalSection lock; // attach and detach, never the audio thread
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LaneGroupWorkers)
+};
@@ -0,0 +1,72 @@
+/*
+  ==============================================================================
+
+    LinearPhaseKernel.h
+
+    FIR kernel with the magnitude response of a set of biquad sections and
+    linear phase: the magnitude is sampled at the FFT bin frequencies, given
+    a delay of half the kernel length, transformed back and windowed. The
+    kernel length grows with the sample rate so the frequency resolution at
+    the low cut stays the same.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "FrequencyResponse.h"
+
+struct LinearPhaseKernel
+{
+    // ~170 ms, 8192 samples at 44.1 / 48 kHz
+    static int getKernelLength(double sampleRate) noexcept
+    {
+        return juce::nextPowerOfTwo(juce::jmax(256, (int)(sampleRate / 6.0)));
+    }
+
+    // the delay the kernel adds, in samples
+    static int getLatency(double sampleRate) noexcept
+    {
+        return getKernelLength(sampleRate) / 2;
+    }
+
+    // allocates, call it off the audio thread
+    static juce::AudioBuffer<float> design(const BiquadCoefficients* sections, int numSections, double sampleRate)
+    {
+        const int length = getKernelLength(sampleRate);
+        const int numBins = length / 2 + 1;
+
+        std::vector<double> frequencies((size_t)numBins);
+
+        for (int bin = 0; bin < numBins; ++bin)
+            frequencies[(size_t)bin] = bin * sampleRate / length;
+
+        FrequencyResponse response;
+        response.prepare(frequencies.data(), numBins, sampleRate);
+        response.addSections(sections, numSections);
+
+        std::vector<double> magnitudes((size_t)numBins);
+        response.getMagnitudes(magnitudes.data());
+
+        // a delay of length / 2 is a sign flip on every other bin, the imaginary parts stay zero
+        std::vector<float> spectrum((size_t)length * 2, 0.f);
+
+        for (int bin = 0; bin < numBins; ++bin)
+            spectrum[(size_t)bin * 2] = (float)((bin & 1) != 0 ? -magnitudes[(size_t)bin] : magnitudes[(size_t)bin]);
+
+        juce::dsp::FFT fft(juce::roundToInt(std::log2(length)));
+        fft.performRealOnlyInverseTransform(spectrum.data());
+
+        // Hann window centred on the peak at length / 2 to keep the truncation ripple down
+        juce::AudioBuffer<float> kernel(1, length);
+        auto* samples = kernel.getWritePointer(0);
+
+        for (int i = 0; i < length; ++i)
+        {
+            const float window = 0.5f - 0.5f * std::cos(juce::MathConstants<float>::twoPi * (float)i / (float)length);
+            samples[i] = spectrum[(size_t)i] * window;
+        }
+
+        return kernel;
+    }
+};
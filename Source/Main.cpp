@@ -0,0 +1,550 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Offline renderer: runs audio files through the SimpleEQ processor
+    without a host, for batch jobs like stem preparation. The settings come
+    from a saved plugin state (the binary blob a host stores, or the older
+    XML), from --set options naming parameters by ID in their own units or
+    choice names (e.g. --set="Peak Gain=-3", --set="Stereo Mode=Mid/Side"),
+    or both, the options applied on top of the state. --save-state writes
+    the result as a state blob for later runs.
+
+    Every file is one job on a thread pool. Files are read, processed and
+    written in chunks of chunkSize samples; WAV and AIFF are read through a
+    memory mapped reader where the file can be mapped. With settings that
+    treat every channel alike (Linked stereo mode, no dynamic bands) the
+    channels are split into groups of one SIMD register's width, each with
+    its own processor, and the groups of a chunk are processed by whichever
+    pool threads are free, so files with many channels use idle threads too.
+    The output is latency compensated and as long as the input.
+
+    usage: SimpleEQRender [--state=<state file>] [--set="<parameter id>=<value>"]...
+                          [--save-state=<state file>] [--output=<directory>] [--suffix=<text, default _eq>]
+                          [--format=<wav|aiff|flac, default: the input's>] [--bits=<16|24|32, default: the input's>]
+                          [--threads=<n>] <files or directories>...
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+#include <algorithm>
+#include <iostream>
+
+//==============================================================================
+static constexpr int chunkSize = 1 << 16; // samples read and written at a time
+static constexpr int blockSize = 4096;    // samples per processBlock call
+
+// channels per processor when they may be split, one lane group of the cascades
+static constexpr int channelsPerGroup = (int)juce::dsp::SIMDRegister<float>::SIMDNumElements;
+
+// juce::dsp::Convolution loads the linear phase kernel on a background thread, processBlock swaps it in
+// and crossfades to it over 50 ms
+static constexpr int kernelLoadTimeoutMs = 10000;
+static constexpr double kernelCrossfadeSeconds = 0.05;
+
+struct RenderOptions
+{
+    juce::MemoryBlock state;        // applied to every processor
+    bool canSplitChannels = false;
+    bool linearPhase = false;
+
+    juce::File outputDirectory;     // next to the input when not set
+    juce::String suffix { "_eq" };
+    juce::String formatExtension;   // the input's format when empty
+    int bitDepth = 0;               // the input's when 0
+};
+
+static juce::CriticalSection outputLock;
+
+static void printLine(const juce::String& message)
+{
+    const juce::ScopedLock lock(outputLock);
+    std::cout << message << std::endl;
+}
+
+static void printError(const juce::String& message)
+{
+    const juce::ScopedLock lock(outputLock);
+    std::cerr << message << std::endl;
+}
+
+// the smallest depth the format can write that holds the wanted one, or its largest
+static int chooseBitDepth(juce::AudioFormat& format, int wantedBitDepth)
+{
+    const auto depths = format.getPossibleBitDepths();
+
+    for (auto depth : depths)
+        if (depth >= wantedBitDepth)
+            return depth;
+
+    return depths.isEmpty() ? wantedBitDepth : depths.getLast();
+}
+
+static std::unique_ptr<SimpleEQAudioProcessor> createProcessor(const RenderOptions& options, int numChannels, double sampleRate)
+{
+    auto processor = std::make_unique<SimpleEQAudioProcessor>();
+    processor->setStateInformation(options.state.getData(), (int)options.state.getSize());
+
+    // main buses only, the sidechain stays disconnected
+    auto layout = processor->getBusesLayout();
+    layout.inputBuses.getReference(0) = juce::AudioChannelSet::canonicalChannelSet(numChannels);
+    layout.outputBuses.getReference(0) = juce::AudioChannelSet::canonicalChannelSet(numChannels);
+
+    for (int bus = 1; bus < layout.inputBuses.size(); ++bus)
+        layout.inputBuses.getReference(bus) = juce::AudioChannelSet::disabled();
+
+    if (! processor->setBusesLayout(layout))
+        return nullptr;
+
+    processor->setNonRealtime(true);
+    processor->setRateAndBufferSizeDetails(sampleRate, blockSize);
+    processor->prepareToPlay(sampleRate, blockSize);
+
+    return processor;
+}
+
+// runs noise through until the kernel is in and the crossfade is over, then starts from a clean state.
+// Returns false if the kernel never arrived.
+static bool installLinearPhaseKernel(SimpleEQAudioProcessor& processor, int numChannels, double sampleRate)
+{
+    juce::AudioBuffer<float> buffer(numChannels, blockSize);
+    juce::MidiBuffer midi;
+    juce::Random random(0x5eed);
+
+    auto processNoise = [&]
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+            for (int i = 0; i < blockSize; ++i)
+                buffer.setSample(ch, i, random.nextFloat() * 0.1f - 0.05f);
+
+        processor.processBlock(buffer, midi);
+    };
+
+    const auto timeout = juce::Time::getMillisecondCounter() + (juce::uint32)kernelLoadTimeoutMs;
+
+    for (processNoise(); ! processor.isLinearPhaseKernelInstalled(); processNoise())
+    {
+        if (juce::Time::getMillisecondCounter() > timeout)
+            return false;
+
+        juce::Thread::sleep(1);
+    }
+
+    const int numCrossfadeBlocks = (int)std::ceil(kernelCrossfadeSeconds * sampleRate / blockSize);
+
+    for (int i = 0; i < numCrossfadeBlocks; ++i)
+        processNoise();
+
+    processor.reset();
+    return true;
+}
+
+//==============================================================================
+class RenderJob : public juce::ThreadPoolJob
+{
+public:
+    RenderJob(juce::ThreadPool& poolToUse, juce::AudioFormatManager& formatManagerToUse, const RenderOptions& optionsToUse,
+              const juce::File& inputFile)
+        : juce::ThreadPoolJob("SimpleEQ Render " + inputFile.getFileName()),
+          pool(poolToUse), formatManager(formatManagerToUse), options(optionsToUse), input(inputFile)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        const auto start = juce::Time::getMillisecondCounterHiRes();
+        const auto error = render();
+
+        if (error.isNotEmpty())
+        {
+            printError(input.getFullPathName() + ": " + error);
+            failed = true;
+        }
+        else
+        {
+            const auto seconds = (juce::Time::getMillisecondCounterHiRes() - start) * 0.001;
+            printLine(input.getFullPathName() + " -> " + output.getFullPathName() + " ("
+                + juce::String(secondsOfAudio / juce::jmax(seconds, 1.0e-6), 1) + "x real time)");
+        }
+
+        return jobHasFinished;
+    }
+
+    bool hasFailed() const noexcept { return failed; }
+
+private:
+    struct ChannelGroup
+    {
+        std::unique_ptr<SimpleEQAudioProcessor> processor;
+        int firstChannel, numChannels;
+        juce::MidiBuffer midi;
+    };
+
+    // takes on the groups of the current chunk that no other thread has claimed yet
+    struct HelperJob : juce::ThreadPoolJob
+    {
+        explicit HelperJob(RenderJob& ownerToHelp) : juce::ThreadPoolJob("SimpleEQ Render Helper"), owner(ownerToHelp) {}
+
+        JobStatus runJob() override
+        {
+            owner.processGroups();
+            return jobHasFinished;
+        }
+
+        RenderJob& owner;
+    };
+
+    juce::String render()
+    {
+        auto* inputFormat = formatManager.findFormatForFileExtension(input.getFileExtension());
+        std::unique_ptr<juce::AudioFormatReader> reader;
+
+        if (inputFormat != nullptr)
+        {
+            std::unique_ptr<juce::MemoryMappedAudioFormatReader> mappedReader(inputFormat->createMemoryMappedReader(input));
+
+            if (mappedReader != nullptr && mappedReader->mapEntireFile())
+                reader = std::move(mappedReader);
+        }
+
+        if (reader == nullptr)
+            reader.reset(formatManager.createReaderFor(input));
+
+        if (reader == nullptr)
+            return "not a readable audio file";
+
+        const int numChannels = (int)reader->numChannels;
+        const double sampleRate = reader->sampleRate;
+        const auto length = reader->lengthInSamples;
+
+        if (numChannels < 1 || sampleRate <= 0.0)
+            return "no audio in the file";
+
+        secondsOfAudio = (double)length / sampleRate;
+
+        if (! options.canSplitChannels && numChannels > SimpleEQAudioProcessor::maxNumChannels)
+            return juce::String(numChannels) + " channels, these settings process up to "
+                 + juce::String(SimpleEQAudioProcessor::maxNumChannels) + " together";
+
+        // one processor for all channels, or one per group when they are independent
+        const int groupSize = options.canSplitChannels ? channelsPerGroup : numChannels;
+
+        for (int first = 0; first < numChannels; first += groupSize)
+        {
+            const int numGroupChannels = juce::jmin(groupSize, numChannels - first);
+            auto processor = createProcessor(options, numGroupChannels, sampleRate);
+
+            if (processor == nullptr)
+                return "unsupported channel count: " + juce::String(numGroupChannels);
+
+            if (options.linearPhase && ! installLinearPhaseKernel(*processor, numGroupChannels, sampleRate))
+                return "the linear phase kernel didn't load within " + juce::String(kernelLoadTimeoutMs / 1000) + " s";
+
+            groups.push_back({ std::move(processor), first, numGroupChannels, {} });
+        }
+
+        auto* outputFormat = options.formatExtension.isNotEmpty() ? formatManager.findFormatForFileExtension(options.formatExtension)
+                                                                  : inputFormat;
+
+        if (outputFormat == nullptr)
+            outputFormat = formatManager.findFormatForFileExtension(".wav");
+
+        const auto outputDirectory = options.outputDirectory == juce::File() ? input.getParentDirectory() : options.outputDirectory;
+        output = outputDirectory.getChildFile(input.getFileNameWithoutExtension() + options.suffix + outputFormat->getFileExtensions()[0]);
+
+        if (output == input)
+            return "the output would overwrite the input, set --output or --suffix";
+
+        // written next to the output and moved over it once complete
+        juce::TemporaryFile temporaryFile(output);
+        std::unique_ptr<juce::OutputStream> stream(temporaryFile.getFile().createOutputStream());
+
+        if (stream == nullptr)
+            return "can't create " + output.getFullPathName();
+
+        const int bitDepth = chooseBitDepth(*outputFormat, options.bitDepth > 0 ? options.bitDepth : (int)reader->bitsPerSample);
+        std::unique_ptr<juce::AudioFormatWriter> writer(outputFormat->createWriterFor(stream.get(), sampleRate, (unsigned int)numChannels,
+                                                                                      bitDepth, reader->metadataValues, 0));
+
+        if (writer == nullptr)
+            return outputFormat->getFormatName() + " can't hold " + juce::String(numChannels) + " channels of "
+                 + juce::String(bitDepth) + " bit at " + juce::String(sampleRate) + " Hz";
+
+        stream.release(); // owned by the writer now
+
+        for (size_t i = 1; i < groups.size(); ++i)
+            helpers.add(new HelperJob(*this));
+
+        // the first latency samples are dropped and as many zeros fed after the end, so the output lines up with the input
+        const auto latency = (juce::int64)groups.front().processor->getLatencySamples();
+        const auto numInputSamples = length + latency;
+
+        chunk.setSize(numChannels, chunkSize);
+        chunkChannels = chunk.getArrayOfWritePointers();
+        bool writeFailed = false;
+
+        for (juce::int64 position = 0; position < numInputSamples; position += chunkSize)
+        {
+            chunkLength = (int)juce::jmin((juce::int64)chunkSize, numInputSamples - position);
+
+            // past the end of the file the reader fills in silence
+            reader->read(&chunk, 0, chunkLength, position, true, true);
+            processChunk();
+
+            const auto firstToWrite = juce::jmax(position, latency);
+            const auto endToWrite = juce::jmin(position + chunkLength, length + latency);
+
+            if (endToWrite > firstToWrite
+                && ! writer->writeFromAudioSampleBuffer(chunk, (int)(firstToWrite - position), (int)(endToWrite - firstToWrite)))
+            {
+                writeFailed = true;
+                break;
+            }
+        }
+
+        // a helper still queued never gets to run, a running one is done with its group already
+        for (auto* helper : helpers)
+            pool.removeJob(helper, false, -1);
+
+        writer.reset();
+
+        if (writeFailed || ! temporaryFile.overwriteTargetFileWithTemporary())
+            return "can't write " + output.getFullPathName();
+
+        return {};
+    }
+
+    void processChunk()
+    {
+        numFinishedGroups.store(0, std::memory_order_relaxed);
+        nextGroup.store(0, std::memory_order_release);
+
+        // helpers only pick up what this thread hasn't got to yet, so the chunk never waits on a queued one
+        for (auto* helper : helpers)
+            if (! pool.contains(helper))
+                pool.addJob(helper, false);
+
+        processGroups();
+
+        // signalled by whichever thread finishes the last group
+        chunkFinished.wait();
+    }
+
+    void processGroups()
+    {
+        for (int index = nextGroup.fetch_add(1, std::memory_order_acq_rel); index < (int)groups.size();
+             index = nextGroup.fetch_add(1, std::memory_order_acq_rel))
+        {
+            auto& group = groups[(size_t)index];
+            auto* const* channels = chunkChannels + group.firstChannel;
+
+            for (int offset = 0; offset < chunkLength; offset += blockSize)
+            {
+                juce::AudioBuffer<float> block(channels, group.numChannels, offset, juce::jmin(blockSize, chunkLength - offset));
+                group.processor->processBlock(block, group.midi);
+            }
+
+            if (numFinishedGroups.fetch_add(1, std::memory_order_acq_rel) + 1 == (int)groups.size())
+                chunkFinished.signal();
+        }
+    }
+
+    juce::ThreadPool& pool;
+    juce::AudioFormatManager& formatManager;
+    const RenderOptions& options;
+    const juce::File input;
+    juce::File output;
+    double secondsOfAudio = 0.0;
+    bool failed = false;
+
+    std::vector<ChannelGroup> groups;
+    juce::OwnedArray<HelperJob> helpers;
+
+    // the chunk every group works on, its channels split between the groups
+    juce::AudioBuffer<float> chunk;
+    float* const* chunkChannels = nullptr;
+    int chunkLength = 0;
+    std::atomic<int> nextGroup { 0 }, numFinishedGroups { 0 };
+    juce::WaitableEvent chunkFinished;
+};
+
+//==============================================================================
+// "<parameter id>=<value>", the value in the parameter's own units or as the text it displays (e.g. a choice name)
+static bool applyParameterOption(SimpleEQAudioProcessor& processor, const juce::String& option)
+{
+    const auto parameterID = option.upToFirstOccurrenceOf("=", false, false).trim();
+    const auto valueText = option.fromFirstOccurrenceOf("=", false, false).trim();
+    auto* param = processor.apvts.getParameter(parameterID);
+
+    if (param == nullptr || valueText.isEmpty())
+    {
+        printError("unknown parameter or missing value: " + option);
+        return false;
+    }
+
+    const bool isNumber = valueText.containsOnly("0123456789.-+eE");
+
+    // getValueForText takes text it doesn't know for the first choice or off, a typo would go unnoticed
+    if (! isNumber)
+    {
+        if (auto* choiceParam = dynamic_cast<juce::AudioParameterChoice*>(param))
+        {
+            if (! choiceParam->choices.contains(valueText))
+            {
+                printError("\"" + valueText + "\" is not a choice of " + parameterID + " (" + choiceParam->choices.joinIntoString(", ") + ")");
+                return false;
+            }
+        }
+        else if (dynamic_cast<juce::AudioParameterBool*>(param) != nullptr)
+        {
+            if (! juce::StringArray { "on", "off", "yes", "no", "true", "false" }.contains(valueText, true))
+            {
+                printError("\"" + valueText + "\" is not a value of " + parameterID + " (on, off, true, false, yes, no, 1, 0)");
+                return false;
+            }
+        }
+    }
+
+    param->setValueNotifyingHost(isNumber ? param->convertTo0to1(valueText.getFloatValue()) : param->getValueForText(valueText));
+
+    return true;
+}
+
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args(argc, argv);
+
+    const auto workingDirectory = juce::File::getCurrentWorkingDirectory();
+
+    // the settings: a saved state, then the single parameters on top
+    SimpleEQAudioProcessor settingsProcessor;
+
+    if (args.containsOption("--state"))
+    {
+        const auto stateFile = workingDirectory.getChildFile(args.getValueForOption("--state"));
+        juce::MemoryBlock state;
+
+        if (! stateFile.loadFileAsData(state) || state.isEmpty())
+        {
+            printError("can't read the state file " + stateFile.getFullPathName());
+            return 1;
+        }
+
+        settingsProcessor.setStateInformation(state.getData(), (int)state.getSize());
+    }
+
+    juce::Array<juce::File> inputs;
+
+    for (auto& argument : args.arguments)
+    {
+        if (argument.text.startsWith("--set="))
+        {
+            if (! applyParameterOption(settingsProcessor, argument.text.fromFirstOccurrenceOf("=", false, false).unquoted()))
+                return 1;
+        }
+        else if (! argument.text.startsWith("-"))
+        {
+            inputs.add(workingDirectory.getChildFile(argument.text));
+        }
+    }
+
+    RenderOptions options;
+    settingsProcessor.getStateInformation(options.state);
+
+    if (args.containsOption("--save-state"))
+    {
+        const auto stateFile = workingDirectory.getChildFile(args.getValueForOption("--save-state"));
+
+        if (! stateFile.replaceWithData(options.state.getData(), options.state.getSize()))
+        {
+            printError("can't write the state file " + stateFile.getFullPathName());
+            return 1;
+        }
+    }
+
+    // channels only go to separate processors where nothing couples them
+    auto& snapshot = settingsProcessor.getChainSettingsSnapshot();
+    snapshot.publishIfDirty();
+    const auto chainSettings = snapshot.read();
+
+    options.linearPhase = settingsProcessor.apvts.getRawParameterValue("Phase Mode")->load() > 0.5f;
+
+    const bool hasDynamicBands = std::any_of(chainSettings.bands.begin(), chainSettings.bands.end(),
+                                             [](const BandSettings& band) { return band.enabled && band.isDynamicBell(); });
+
+    // linear phase mode ignores the stereo modes and the dynamics, the kernel is the same for every channel
+    options.canSplitChannels = options.linearPhase || (chainSettings.stereoMode == StereoMode::Linked && ! hasDynamicBands);
+
+    if (args.containsOption("--output"))
+    {
+        options.outputDirectory = workingDirectory.getChildFile(args.getValueForOption("--output"));
+
+        if (! options.outputDirectory.createDirectory())
+        {
+            printError("can't create " + options.outputDirectory.getFullPathName());
+            return 1;
+        }
+    }
+
+    if (args.containsOption("--suffix"))
+        options.suffix = args.getValueForOption("--suffix");
+
+    if (args.containsOption("--format"))
+        options.formatExtension = "." + args.getValueForOption("--format").trimCharactersAtStart(".");
+
+    if (args.containsOption("--bits"))
+        options.bitDepth = juce::jlimit(8, 32, args.getValueForOption("--bits").getIntValue());
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    if (options.formatExtension.isNotEmpty() && formatManager.findFormatForFileExtension(options.formatExtension) == nullptr)
+    {
+        printError("unknown output format: " + options.formatExtension);
+        return 1;
+    }
+
+    // directories are searched for every format that can be read
+    juce::Array<juce::File> files;
+
+    for (auto& input : inputs)
+    {
+        if (input.isDirectory())
+            files.addArray(input.findChildFiles(juce::File::findFiles, true, formatManager.getWildcardForAllFormats()));
+        else
+            files.add(input);
+    }
+
+    if (files.isEmpty())
+        return args.containsOption("--save-state") ? 0 : 1;
+
+    int numThreads = juce::SystemStats::getNumCpus();
+
+    if (args.containsOption("--threads"))
+        numThreads = juce::jmax(1, args.getValueForOption("--threads").getIntValue());
+
+    juce::OwnedArray<RenderJob> jobs;
+    juce::ThreadPool pool(numThreads);
+
+    for (auto& file : files)
+        pool.addJob(jobs.add(new RenderJob(pool, formatManager, options, file)), false);
+
+    int numFailed = 0;
+
+    for (auto* job : jobs)
+    {
+        pool.waitForJobToFinish(job, -1);
+
+        if (job->hasFailed())
+            ++numFailed;
+    }
+
+    printLine(juce::String(files.size() - numFailed) + " of " + juce::String(files.size()) + " files rendered");
+
+    return numFailed == 0 ? 0 : 1;
+}
@@ -192,9 +192,11 @@ juce::String RotarySliderWithLabels::getDisplayString() const
 // ResponseCurveComponent
 //==============================================================================
 ResponseCurveComponent::ResponseCurveComponent(SimpleEQAudioProcessor& audioProcessor)
-    : audioProcessor(audioProcessor)
+    : audioProcessor(audioProcessor),
+    preEqAnalyzer(audioProcessor.getPreEqFifo()),
+    postEqAnalyzer(audioProcessor.getPostEqFifo())
 {
-
+    bandNeedsUpdate.fill(true);
 }
 
 ResponseCurveComponent::~ResponseCurveComponent()
@@ -207,10 +209,13 @@ void ResponseCurveComponent::paint(juce::Graphics& g)
     auto analysisArea = getAnalysisArea();
     auto renderArea = getRenderArea();
 
-    // draw backgroundGrid
-    //g.drawImageAt(backgroundGrid, renderArea.getX(), renderArea.getY());
-    drawFreqLabels(g);
-    drawAnalysisGrid(g);
+    // draw backgroundGrid, rasterised at the physical pixel density of the current display
+    const float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+
+    if (backgroundGrid.isNull() || scale != backgroundGridScale)
+        renderBackgroundGrid(scale);
+
+    g.drawImage(backgroundGrid, getLocalBounds().toFloat());
 
     //g.setColour(juce::Colours::yellow);
     //g.drawRect(getAnalysisArea());
@@ -218,32 +223,23 @@ void ResponseCurveComponent::paint(juce::Graphics& g)
     //g.setColour(juce::Colours::red);
     //g.drawRect(getRenderArea());
 
-    // draw ResponseCurve
-    int width = analysisArea.getWidth();
+    // draw spectrum before and after the EQ
+    g.setColour(juce::Colours::lightsteelblue.withAlpha(0.5f));
+    g.strokePath(preEqAnalyzer.getPath(), juce::PathStrokeType(1.f));
 
-    std::vector<double> magnitudes(width, 1.f);
+    g.setColour(juce::Colours::orange.withAlpha(0.8f));
+    g.strokePath(postEqAnalyzer.getPath(), juce::PathStrokeType(1.f));
 
-    updateMagnitudes(magnitudes, width);
+    // draw ResponseCurve, only recomputing what changed since the last repaint
+    if ((int)frequencies.size() != analysisArea.getWidth())
+        updateFrequencyTable(analysisArea.getWidth());
 
-    juce::Path responseCurve;
+    for (int band = 0; band < NumBands; ++band)
+        if (bandNeedsUpdate[band])
+            updateBandMagnitudes(static_cast<Band>(band));
 
-    const double outputMin = analysisArea.getBottom();
-    const double outputMax = analysisArea.getY();
-
-    // lambda to map input value y-coordinate
-    auto map = [outputMin, outputMax](double input)
-        {
-            return juce::jmap(input, -24.0, 24.0, outputMin, outputMax);
-        };
-
-    responseCurve.startNewSubPath( analysisArea.getX(), map(magnitudes[0]) );
-
-    for (size_t i = 1; i < magnitudes.size(); i++)
-    {
-        double y = map(magnitudes[i]);
-        //if (y < renderArea.getBottom())
-        responseCurve.lineTo( analysisArea.getX() + i, map(magnitudes[i]) );
-    }
+    if (responseCurveNeedsUpdate)
+        updateResponseCurve();
 
     g.setColour(juce::Colours::white);
     g.strokePath( responseCurve, juce::PathStrokeType(2.f) );
@@ -255,42 +251,38 @@ void ResponseCurveComponent::paint(juce::Graphics& g)
 
 void ResponseCurveComponent::resized() {
 
-    // preparation backgroundGrid    
- /*   juce::Rectangle<float> analysisArea = getAnalysisArea().toFloat();
-    juce::Rectangle<float> renderArea = getRenderArea().toFloat();
+    // grid and labels depend on the size only, render them again on the next paint
+    backgroundGrid = juce::Image();
 
-    auto x_offset = analysisArea.getX() - renderArea.getX();
-    auto y_offset = renderArea.getBottom() - analysisArea.getBottom();
+    updateFrequencyTable(getAnalysisArea().getWidth());
 
-    backgroundGrid = juce::Image(juce::Image::PixelFormat::RGB, renderArea.getWidth(), renderArea.getHeight(), true);
-    juce::Graphics g(backgroundGrid);*/
+    preEqAnalyzer.setBounds(getAnalysisArea().toFloat());
+    postEqAnalyzer.setBounds(getAnalysisArea().toFloat());
+};
 
-    //auto left = analysisArea.getX();
-    //auto right = analysisArea.getRight();
-    //auto top = analysisArea.getY();
-    //auto bottom = analysisArea.getBottom();
-    //auto width = analysisArea.getWidth();
+bool ResponseCurveComponent::updateAnalyzers()
+{
+    const bool preEqChanged = preEqAnalyzer.pullPath();
+    const bool postEqChanged = postEqAnalyzer.pullPath();
 
+    return preEqChanged || postEqChanged;
+}
 
-    //// draw backgroundGrid
-    //    g.setColour(juce::Colours::steelblue);
+void ResponseCurveComponent::renderBackgroundGrid(float scale)
+{
+    backgroundGridScale = scale;
 
-    //    for (float f : getFreqs()) {
-    //        // map to normalised value
-    //        float normX = juce::mapFromLog10(f, 20.f, 20000.f);
+    backgroundGrid = juce::Image(juce::Image::PixelFormat::ARGB,
+                                 juce::jmax(1, juce::roundToInt(getWidth() * scale)),
+                                 juce::jmax(1, juce::roundToInt(getHeight() * scale)),
+                                 true);
 
-    //        // draw line
-    //        g.drawVerticalLine(analysisArea.getWidth() * normX + x_offset, 0.f, renderArea.getHeight());
-    //    }
+    juce::Graphics g(backgroundGrid);
+    g.addTransform(juce::AffineTransform::scale(scale));
 
-    //    for (float gain : getGains())
-    //    {
-    //        // normalise
-    //        auto y = juce::jmap(gain, -24.f, 24.f, 0.f, analysisArea.getHeight());
-    //        g.setColour(gain == 0 ? juce::Colours::greenyellow : juce::Colours::steelblue);
-    //        g.drawHorizontalLine(y + y_offset, 0.f, renderArea.getWidth());
-    //    }
-};
+    drawFreqLabels(g);
+    drawAnalysisGrid(g);
+}
 
 void ResponseCurveComponent::drawAnalysisGrid(juce::Graphics& g)
 {
@@ -399,53 +391,206 @@ juce::Rectangle<int> ResponseCurveComponent::getAnalysisArea() {
     return analysisArea;
 }
 
-void ResponseCurveComponent::updateMagnitudes(std::vector<double>& magnitudes, int width)
+void ResponseCurveComponent::updateFrequencyTable(int width)
 {
-    double sampleRate = audioProcessor.getSampleRate();
+    width = juce::jmax(0, width);
+
+    frequencies.resize((size_t)width);
 
     for (int i = 0; i < width; i++)
-    {
-        double mag = 1.f;
+        frequencies[(size_t)i] = juce::mapToLog10(double(i) / double(width), 20.0, 20000.0);
 
-        double freq = juce::mapToLog10(double(i) / double(width), 20.0, 20000.0);
+    frequencyResponse.prepare(frequencies.data(), width, displayedSampleRate);
 
-        if (peakCoefficients != nullptr)
-        { 
-            double peakCoeff = peakCoefficients->getMagnitudeForFrequency(freq, sampleRate);
-            mag *= peakCoeff;
-        }
+    bandNeedsUpdate.fill(true);
+    responseCurveNeedsUpdate = true;
+}
+
+void ResponseCurveComponent::updateBandMagnitudes(Band band)
+{
+    auto& magnitudes = bandMagnitudes[band];
+    magnitudes.resize(frequencies.size());
+
+    frequencyResponse.reset();
+
+    if (band == LowCutBand)
+        frequencyResponse.addSections(lowCutCoefficients.data(), numLowCutSections);
+    else if (band == HighCutBand)
+        frequencyResponse.addSections(highCutCoefficients.data(), numHighCutSections);
+    else if (eqBandActive[(size_t)(band - FirstEqBand)])
+        frequencyResponse.addSection(eqBandCoefficients[(size_t)(band - FirstEqBand)]);
+
+    frequencyResponse.getMagnitudesInDecibels(magnitudes.data());
+
+    bandNeedsUpdate[band] = false;
+    responseCurveNeedsUpdate = true;
+}
+
+void ResponseCurveComponent::updateResponseCurve()
+{
+    auto analysisArea = getAnalysisArea();
+
+    const double outputMin = analysisArea.getBottom();
+    const double outputMax = analysisArea.getY();
 
-        for (auto filter : lowCutCoefficients)
+    // lambda to map input value y-coordinate
+    auto map = [outputMin, outputMax](double input)
         {
-            if (filter != nullptr)
-            {
-                mag *= filter->getMagnitudeForFrequency(freq, sampleRate);
-            }
-        }
+            return juce::jmap(input, -24.0, 24.0, outputMin, outputMax);
+        };
+
+    responseCurve.clear();
+    responseCurve.preallocateSpace(3 * (int)frequencies.size());
+
+    for (size_t i = 0; i < frequencies.size(); i++)
+    {
+        double magnitude = bandMagnitudes[LowCutBand][i] + bandMagnitudes[HighCutBand][i];
+
+        for (int band = FirstEqBand; band < NumBands; ++band)
+            if (eqBandActive[(size_t)(band - FirstEqBand)])
+                magnitude += bandMagnitudes[(size_t)band][i];
+
+        if (i == 0)
+            responseCurve.startNewSubPath(analysisArea.getX(), map(magnitude));
+        else
+            responseCurve.lineTo(analysisArea.getX() + i, map(magnitude));
+    }
 
-        for (auto filter : highCutCoefficients)
+    responseCurveNeedsUpdate = false;
+}
+
+void ResponseCurveComponent::updateFilters(const ChainSettings& chainSettings)
+{
+    // the filters run at the oversampled rate, show the response they really have
+    double sampleRate = audioProcessor.getProcessingSampleRate();
+
+    // nothing to design for before prepareToPlay, updateSampleRate() picks the settings up once there is a rate
+    if (sampleRate <= 0.0)
+    {
+        displayedSettings = chainSettings;
+        hasDisplayedSettings = false;
+        return;
+    }
+
+    const bool redesignAll = ! hasDisplayedSettings || sampleRate != displayedSampleRate;
+
+    for (size_t i = 0; i < (size_t)maxBands; ++i)
+    {
+        const auto& band = chainSettings.bands[i];
+
+        if (redesignAll || band != displayedSettings.bands[i])
         {
-            if (filter != nullptr)
-            {
-                mag *= filter->getMagnitudeForFrequency(freq, sampleRate);
-            }
+            eqBandActive[i] = isBandActive(band);
+
+            if (eqBandActive[i])
+                eqBandCoefficients[i] = makeBandCoefficients(band, sampleRate);
+
+            bandNeedsUpdate[FirstEqBand + i] = true;
         }
-        
-        magnitudes[i] = juce::Decibels::gainToDecibels(mag);
+    }
+
+    // show the cuts only when the processor actually runs them
+    if (redesignAll
+        || chainSettings.lowCutFreq != displayedSettings.lowCutFreq
+        || chainSettings.lowCutSlope != displayedSettings.lowCutSlope)
+    {
+        numLowCutSections = getNumLowCutSections(chainSettings);
+        SosDesigner::designCut(lowCutCoefficients.data(), numLowCutSections, chainSettings.lowCutFreq, sampleRate, true);
+        bandNeedsUpdate[LowCutBand] = true;
+    }
+
+    if (redesignAll
+        || chainSettings.highCutFreq != displayedSettings.highCutFreq
+        || chainSettings.highCutSlope != displayedSettings.highCutSlope)
+    {
+        numHighCutSections = getNumHighCutSections(chainSettings);
+        SosDesigner::designCut(highCutCoefficients.data(), numHighCutSections, chainSettings.highCutFreq, sampleRate, false);
+        bandNeedsUpdate[HighCutBand] = true;
+    }
+
+    displayedSettings = chainSettings;
+    hasDisplayedSettings = true;
+
+    if (sampleRate != displayedSampleRate)
+    {
+        displayedSampleRate = sampleRate;
+        updateFrequencyTable((int)frequencies.size());
     }
 }
 
-void ResponseCurveComponent::updateFilters()
+bool ResponseCurveComponent::updateSampleRate()
 {
-    ChainSettings chainSettings = getChainSettings(audioProcessor.apvts);
-    double sampleRate = audioProcessor.getSampleRate();
-    this->peakCoefficients = makePeakFilter(chainSettings, sampleRate);
-    this->lowCutCoefficients = makeLowCutFilter(chainSettings, sampleRate);
-    this->highCutCoefficients = makeHighCutFilter(chainSettings, sampleRate);
+    const double sampleRate = audioProcessor.getProcessingSampleRate();
+
+    if (sampleRate <= 0.0 || sampleRate == displayedSampleRate)
+        return false;
+
+    updateFilters(displayedSettings);
+    return true;
 }
 
 
+// DspLoadOverlay
 //==============================================================================
+DspLoadOverlay::DspLoadOverlay(SimpleEQAudioProcessor& p) : audioProcessor(p)
+{
+}
+
+bool DspLoadOverlay::update()
+{
+    const auto version = audioProcessor.getDspLoadVersion();
+
+    if (version == displayedVersion)
+        return false;
+
+    displayedVersion = version;
+    load = audioProcessor.getDspLoad();
+    return true;
+}
+
+void DspLoadOverlay::paint(juce::Graphics& g)
+{
+    auto bounds = getLocalBounds().toFloat();
+
+    g.setColour(juce::Colours::black.withAlpha(0.75f));
+    g.fillRoundedRectangle(bounds, 4.f);
+
+    bounds.reduce(6.f, 4.f);
+
+    const auto toPercent = [](float value) { return juce::String(juce::roundToInt(value * 100.f)) + "%"; };
+
+    juce::String text;
+    text << "avg " << toPercent(load.averageLoad)
+         << "  peak " << toPercent(load.windowWorstLoad)
+         << "  worst " << toPercent(load.worstLoad);
+
+    if (load.numOverloads > 0)
+        text << "  over " << load.numOverloads;
+
+    g.setColour(load.numOverloads > 0 ? juce::Colours::orangered : juce::Colours::white);
+    g.setFont(12.f);
+    g.drawFittedText(text, bounds.removeFromTop(14.f).toNearestInt(), juce::Justification::centredLeft, 1);
+
+    bounds.removeFromTop(3.f);
+
+    // one bar per 10 % of the budget, the last one for the blocks over budget
+    const int maxCount = juce::jmax(1, *std::max_element(load.histogram.begin(), load.histogram.end()));
+    const float barWidth = bounds.getWidth() / DspLoadSnapshot::numBins;
+
+    for (int bin = 0; bin < DspLoadSnapshot::numBins; ++bin)
+    {
+        const float barHeight = bounds.getHeight() * load.histogram[(size_t)bin] / maxCount;
+
+        g.setColour(bin == DspLoadSnapshot::numBins - 1 ? juce::Colours::orangered : juce::Colours::skyblue);
+        g.fillRect(bounds.getX() + bin * barWidth + 1.f, bounds.getBottom() - barHeight, barWidth - 2.f, barHeight);
+    }
+}
+
+void DspLoadOverlay::mouseDown(const juce::MouseEvent&)
+{
+    audioProcessor.resetDspLoadWorstCase();
+}
+
 SimpleEQAudioProcessorEditor::SimpleEQAudioProcessorEditor (SimpleEQAudioProcessor& p)
     : AudioProcessorEditor (&p), audioProcessor (p),
     // Slider
@@ -456,16 +601,18 @@ SimpleEQAudioProcessorEditor::SimpleEQAudioProcessorEditor (SimpleEQAudioProcess
     lowCutFreqSlider(*audioProcessor.apvts.getParameter("LowCut Freq"), "Hz"),
     highCutSlopeSlider(*audioProcessor.apvts.getParameter("HighCut Slope"), "db/Oct"),
     highCutFreqSlider(*audioProcessor.apvts.getParameter("HighCut Freq"), "Hz"),
+    dynamicThresholdSlider(*audioProcessor.apvts.getParameter("Peak Threshold"), "dB"),
+    dynamicRatioSlider(*audioProcessor.apvts.getParameter("Peak Ratio"), ""),
+    dynamicAttackSlider(*audioProcessor.apvts.getParameter("Peak Attack"), "ms"),
+    dynamicReleaseSlider(*audioProcessor.apvts.getParameter("Peak Release"), "ms"),
 
     // response curve
     responseCurveComponent(audioProcessor),
+    dspLoadOverlay(audioProcessor),
 
     // Slider Attachments
     lowCutSlopeSliderAttachment(audioProcessor.apvts, "LowCut Slope", lowCutSlopeSlider),
     lowCutFreqSliderAttachment(audioProcessor.apvts, "LowCut Freq", lowCutFreqSlider),
-    peakFilterQualitySliderAttachment(audioProcessor.apvts, "Peak Quality", peakFilterQualitySlider),
-    peakFilterGainSliderAttachment(audioProcessor.apvts, "Peak Gain", peakFilterGainSlider),
-    peakFilterFreqSliderAttachment(audioProcessor.apvts, "Peak Freq", peakFilterFreqSlider),
     highCutSlopeSliderAttachment(audioProcessor.apvts, "HighCut Slope", highCutSlopeSlider),
     highCutFreqSliderAttachment(audioProcessor.apvts, "HighCut Freq", highCutFreqSlider)  
 {
@@ -489,36 +636,78 @@ SimpleEQAudioProcessorEditor::SimpleEQAudioProcessorEditor (SimpleEQAudioProcess
     highCutSlopeSlider.labels.add({ 1.f, "48db/Oct" });
     highCutFreqSlider.labels.add({ 0.f, "20Hz" });
     highCutFreqSlider.labels.add({ 1.f, "20kHz" });
+
+    dynamicThresholdSlider.labels.add({ 0.f, "-60dB" });
+    dynamicThresholdSlider.labels.add({ 1.f, "0dB" });
+    dynamicRatioSlider.labels.add({ 0.f, "1:1" });
+    dynamicRatioSlider.labels.add({ 1.f, "20:1" });
+    dynamicAttackSlider.labels.add({ 0.f, "0.1ms" });
+    dynamicAttackSlider.labels.add({ 1.f, "200ms" });
+    dynamicReleaseSlider.labels.add({ 0.f, "5ms" });
+    dynamicReleaseSlider.labels.add({ 1.f, "2s" });
+
+    // every band has the same choices as the first
+    const auto firstBandIDs = getBandParameterIDs(0);
+
+    for (int band = 0; band < maxBands; ++band)
+        bandSelector.addItem("Band " + juce::String(band + 1), band + 1);
+
+    if (auto* typeParam = dynamic_cast<juce::AudioParameterChoice*>(audioProcessor.apvts.getParameter(firstBandIDs.type)))
+        bandTypeComboBox.addItemList(typeParam->choices, 1);
+
+    if (auto* channelParam = dynamic_cast<juce::AudioParameterChoice*>(audioProcessor.apvts.getParameter(firstBandIDs.channel)))
+        bandChannelComboBox.addItemList(channelParam->choices, 1);
+
+    if (auto* stereoModeParam = dynamic_cast<juce::AudioParameterChoice*>(audioProcessor.apvts.getParameter("Stereo Mode")))
+        stereoModeComboBox.addItemList(stereoModeParam->choices, 1);
+
+    stereoModeAttachment = std::make_unique<ComboBoxAttachment>(audioProcessor.apvts, "Stereo Mode", stereoModeComboBox);
+    stereoModeComboBox.onChange = [this] { bandChannelComboBox.setEnabled(stereoModeComboBox.getSelectedItemIndex() > 0); };
+    bandChannelComboBox.setEnabled(stereoModeComboBox.getSelectedItemIndex() > 0);
+
+    if (auto* sourceParam = dynamic_cast<juce::AudioParameterChoice*>(audioProcessor.apvts.getParameter("Dynamic Source")))
+        dynamicSourceComboBox.addItemList(sourceParam->choices, 1);
+
+    dynamicSourceAttachment = std::make_unique<ComboBoxAttachment>(audioProcessor.apvts, "Dynamic Source", dynamicSourceComboBox);
+
+    bandTypeComboBox.onChange = [this] { updateDynamicControls(); };
+    bandDynamicButton.onClick = [this] { updateDynamicControls(); };
+
+    bandSelector.setSelectedId(1, juce::dontSendNotification);
+    bandSelector.onChange = [this] { selectBand(bandSelector.getSelectedId() - 1); };
+    selectBand(0);
     
     for (auto* component : SimpleEQAudioProcessorEditor::getComponents())
     {
         addAndMakeVisible(component);
     }
 
-    const juce::Array<juce::AudioProcessorParameter*>& params = audioProcessor.getParameters();
-
-    for (auto param : params)
+    // the overlay sits on top of the response curve; the processor meters every block, the overlay only
+    // picks up its windows while shown
+    addChildComponent(dspLoadOverlay);
+    dspLoadButton.onClick = [this]
     {
-        param->addListener(this);
-    }
+        dspLoadOverlay.setVisible(dspLoadButton.getToggleState());
+        dspLoadOverlay.update();
+    };
 
-    responseCurveComponent.updateFilters();
+    auto& snapshot = audioProcessor.getChainSettingsSnapshot();
+    snapshot.publishIfDirty();
+    displayedSettingsVersion = snapshot.getVersion();
+    responseCurveComponent.updateFilters(snapshot.read());
 
-    startTimer(60);
+    audioProcessor.setAnalyzerEnabled(true);
 
-    setSize (800, 500);
+    startTimerHz(30);
+
+    setSize (900, 540);
 }
 
 
 
 SimpleEQAudioProcessorEditor::~SimpleEQAudioProcessorEditor()
 {
-    const juce::Array<juce::AudioProcessorParameter*>& params = audioProcessor.getParameters();
-
-    for (auto param : params)
-    {
-        param->removeListener(this);
-    }
+    audioProcessor.setAnalyzerEnabled(false);
 }
 
 //==============================================================================
@@ -545,11 +734,32 @@ void SimpleEQAudioProcessorEditor::resized()
     slidersArea.removeFromTop(7);
     slidersArea.removeFromBottom(7);
    
-    float FilterAreaSize = area.getWidth() * 0.33;
+    float FilterAreaSize = area.getWidth() * 0.25;
     auto lowCutArea = slidersArea.removeFromLeft(FilterAreaSize);
     auto peakFilterArea = slidersArea.removeFromLeft(FilterAreaSize);
+    auto dynamicsArea = slidersArea.removeFromLeft(FilterAreaSize);
     auto highCutArea = slidersArea;
 
+    // dynamic on / off and the detector source above the selected band's threshold, ratio, attack and release
+    auto dynamicsHeaderArea = dynamicsArea.removeFromTop(24).reduced(4, 0);
+    bandDynamicButton.setBounds(dynamicsHeaderArea.removeFromLeft(dynamicsHeaderArea.getWidth() * 0.45).reduced(2, 0));
+    dynamicSourceComboBox.setBounds(dynamicsHeaderArea.reduced(2, 0));
+
+    auto dynamicsTopArea = dynamicsArea.removeFromTop(dynamicsArea.getHeight() * 0.5);
+    dynamicThresholdSlider.setBounds(dynamicsTopArea.removeFromLeft(dynamicsTopArea.getWidth() / 2));
+    dynamicRatioSlider.setBounds(dynamicsTopArea);
+    dynamicAttackSlider.setBounds(dynamicsArea.removeFromLeft(dynamicsArea.getWidth() / 2));
+    dynamicReleaseSlider.setBounds(dynamicsArea);
+
+    // band selector, on / off, type and channel above the band's sliders
+    auto bandArea = peakFilterArea.removeFromTop(24).reduced(4, 0);
+    bandSelector.setBounds(bandArea.removeFromLeft(bandArea.getWidth() * 0.35).reduced(2, 0));
+    bandEnabledButton.setBounds(bandArea.removeFromLeft(bandArea.getWidth() * 0.3).reduced(2, 0));
+    bandTypeComboBox.setBounds(bandArea.reduced(2, 0));
+
+    peakFilterArea.removeFromTop(4);
+    bandChannelComboBox.setBounds(peakFilterArea.removeFromTop(24).reduced(6, 0));
+
     auto lowCutSlopeSliderArea = lowCutArea.removeFromTop(lowCutArea.getHeight() * 0.5);
     auto lowCutFreqSliderArea = lowCutArea;
 
@@ -563,6 +773,12 @@ void SimpleEQAudioProcessorEditor::resized()
 
     responseCurveComponent.setBounds(responseCurveArea);
 
+    auto dspLoadArea = responseCurveArea.reduced(8).removeFromTop(60).removeFromRight(220);
+    dspLoadButton.setBounds(dspLoadArea.removeFromTop(20).removeFromRight(90));
+    dspLoadOverlay.setBounds(dspLoadArea);
+
+    stereoModeComboBox.setBounds(responseCurveArea.reduced(8).removeFromTop(20).removeFromLeft(110));
+
     lowCutSlopeSlider.setBounds(lowCutSlopeSliderArea);
     lowCutFreqSlider.setBounds(lowCutFreqSliderArea);
 
@@ -574,20 +790,85 @@ void SimpleEQAudioProcessorEditor::resized()
     highCutFreqSlider.setBounds(highCutFreqSliderArea);
 }
 
-void SimpleEQAudioProcessorEditor::parameterValueChanged (int parameterIndex, float newValue)
+void SimpleEQAudioProcessorEditor::timerCallback()
 {
-    parametersChanged.set(true);
+    auto& snapshot = audioProcessor.getChainSettingsSnapshot();
+    snapshot.publishIfDirty();
+
+    // a publish in progress just means we look again on the next tick
+    ChainSettings chainSettings;
+    uint32_t version;
+
+    bool needsRepaint = responseCurveComponent.updateAnalyzers();
+
+    if (snapshot.tryRead(chainSettings, version) && version != displayedSettingsVersion)
+    {
+        displayedSettingsVersion = version;
+        responseCurveComponent.updateFilters(chainSettings);
+        needsRepaint = true;
+    }
+
+    // the processor got prepared or switched the oversampling factor without a settings change
+    if (responseCurveComponent.updateSampleRate())
+        needsRepaint = true;
+
+    if (needsRepaint)
+        responseCurveComponent.repaint();
+
+    if (dspLoadOverlay.isVisible() && dspLoadOverlay.update())
+        dspLoadOverlay.repaint();
 }
 
-void SimpleEQAudioProcessorEditor::parameterGestureChanged(int parameterIndex, bool gestureIsStarting) { };
+void SimpleEQAudioProcessorEditor::selectBand(int band)
+{
+    const auto ids = getBandParameterIDs(band);
+    auto& apvts = audioProcessor.apvts;
+
+    // the old attachments go first, or moving a slider to the new band would write to the old one
+    peakFilterQualitySliderAttachment.reset();
+    peakFilterGainSliderAttachment.reset();
+    peakFilterFreqSliderAttachment.reset();
+    dynamicThresholdSliderAttachment.reset();
+    dynamicRatioSliderAttachment.reset();
+    dynamicAttackSliderAttachment.reset();
+    dynamicReleaseSliderAttachment.reset();
+    bandTypeAttachment.reset();
+    bandChannelAttachment.reset();
+    bandEnabledAttachment.reset();
+    bandDynamicAttachment.reset();
+
+    peakFilterQualitySlider.setParameter(*apvts.getParameter(ids.quality));
+    peakFilterGainSlider.setParameter(*apvts.getParameter(ids.gain));
+    peakFilterFreqSlider.setParameter(*apvts.getParameter(ids.freq));
+    dynamicThresholdSlider.setParameter(*apvts.getParameter(ids.threshold));
+    dynamicRatioSlider.setParameter(*apvts.getParameter(ids.ratio));
+    dynamicAttackSlider.setParameter(*apvts.getParameter(ids.attack));
+    dynamicReleaseSlider.setParameter(*apvts.getParameter(ids.release));
+
+    peakFilterQualitySliderAttachment = std::make_unique<SliderAttachment>(apvts, ids.quality, peakFilterQualitySlider);
+    peakFilterGainSliderAttachment = std::make_unique<SliderAttachment>(apvts, ids.gain, peakFilterGainSlider);
+    peakFilterFreqSliderAttachment = std::make_unique<SliderAttachment>(apvts, ids.freq, peakFilterFreqSlider);
+    bandTypeAttachment = std::make_unique<ComboBoxAttachment>(apvts, ids.type, bandTypeComboBox);
+    bandChannelAttachment = std::make_unique<ComboBoxAttachment>(apvts, ids.channel, bandChannelComboBox);
+    bandEnabledAttachment = std::make_unique<ButtonAttachment>(apvts, ids.enabled, bandEnabledButton);
+    dynamicThresholdSliderAttachment = std::make_unique<SliderAttachment>(apvts, ids.threshold, dynamicThresholdSlider);
+    dynamicRatioSliderAttachment = std::make_unique<SliderAttachment>(apvts, ids.ratio, dynamicRatioSlider);
+    dynamicAttackSliderAttachment = std::make_unique<SliderAttachment>(apvts, ids.attack, dynamicAttackSlider);
+    dynamicReleaseSliderAttachment = std::make_unique<SliderAttachment>(apvts, ids.release, dynamicReleaseSlider);
+    bandDynamicAttachment = std::make_unique<ButtonAttachment>(apvts, ids.dynamic, bandDynamicButton);
+
+    updateDynamicControls();
+}
 
-void SimpleEQAudioProcessorEditor::timerCallback()
+void SimpleEQAudioProcessorEditor::updateDynamicControls()
 {
-    if (parametersChanged.compareAndSetBool(false, true))
-    {  
-        responseCurveComponent.updateFilters();
-        responseCurveComponent.repaint();
-    }
+    const bool isBell = bandTypeComboBox.getSelectedId() == (int)BandType::Bell + 1;
+    const bool isDynamic = isBell && bandDynamicButton.getToggleState();
+
+    bandDynamicButton.setEnabled(isBell);
+
+    for (auto* slider : { &dynamicThresholdSlider, &dynamicRatioSlider, &dynamicAttackSlider, &dynamicReleaseSlider })
+        slider->setEnabled(isDynamic);
 }
 
 std::vector<juce::Component*> SimpleEQAudioProcessorEditor::getComponents() {
@@ -600,7 +881,19 @@ std::vector<juce::Component*> SimpleEQAudioProcessorEditor::getComponents() {
         &peakFilterFreqSlider,
         &lowCutSlopeSlider,
         &highCutSlopeSlider,
-        &responseCurveComponent
+        &bandSelector,
+        &bandEnabledButton,
+        &bandTypeComboBox,
+        &bandChannelComboBox,
+        &bandDynamicButton,
+        &dynamicSourceComboBox,
+        &dynamicThresholdSlider,
+        &dynamicRatioSlider,
+        &dynamicAttackSlider,
+        &dynamicReleaseSlider,
+        &responseCurveComponent,
+        &dspLoadButton,
+        &stereoModeComboBox
     };
 }
 
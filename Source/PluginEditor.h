@@ -10,6 +10,7 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "FrequencyResponse.h"
 
 
 
@@ -48,6 +49,9 @@ struct RotarySliderWithLabels : juce::Slider {
     int getTextHeight() const { return 14; }
     juce::String getDisplayString() const;
 
+    // for the band sliders, which follow the band selector
+    void setParameter(juce::RangedAudioParameter& rap) { param = &rap; repaint(); }
+
 private:
     LookAndFeel lnf;
     juce::RangedAudioParameter* param;
@@ -60,33 +64,81 @@ struct ResponseCurveComponent : juce::Component {
         ResponseCurveComponent(SimpleEQAudioProcessor&);
         ~ResponseCurveComponent();
         
-        void updateFilters();
+        void updateFilters(const ChainSettings& chainSettings);
+
+        // redesigns the displayed settings if the processor's rate moved, returns true if it did
+        bool updateSampleRate();
+
+        // returns true if either analyser published a new spectrum
+        bool updateAnalyzers();
 
     private:
+        enum Band { LowCutBand, HighCutBand, FirstEqBand, NumBands = FirstEqBand + maxBands };
+
         SimpleEQAudioProcessor& audioProcessor;
-        Coefficients peakCoefficients;
-        CoefficientsArray lowCutCoefficients;
-        CoefficientsArray highCutCoefficients;
+        std::array<BiquadCoefficients, maxBands> eqBandCoefficients;
+        std::array<bool, maxBands> eqBandActive {};
+        std::array<BiquadCoefficients, SosDesigner::maxCutSections> lowCutCoefficients, highCutCoefficients;
+        int numLowCutSections = 0, numHighCutSections = 0;
+        // grid and frequency labels, rendered once per size and display scale
         juce::Image backgroundGrid;
+        float backgroundGridScale = 0.f;
+
+        // what the coefficients above were made from, to find the bands that changed
+        ChainSettings displayedSettings;
+        double displayedSampleRate = 0.0;
+        bool hasDisplayedSettings = false;
+
+        // log-spaced frequency of every pixel column of the analysis area
+        std::vector<double> frequencies;
+        FrequencyResponse frequencyResponse;
+
+        // magnitude response in dB per band, one value per frequency
+        std::array<std::vector<double>, NumBands> bandMagnitudes;
+        std::array<bool, NumBands> bandNeedsUpdate {};
+
+        juce::Path responseCurve;
+        bool responseCurveNeedsUpdate = true;
+
+        SpectrumAnalyzer preEqAnalyzer, postEqAnalyzer;
 
         void paint(juce::Graphics& g) override;
         void resized() override;
+        void renderBackgroundGrid(float scale);
         void ResponseCurveComponent::drawAnalysisGrid(juce::Graphics& g);
         void drawFreqLabels(juce::Graphics& g);
         std::vector<float> getGains();
         std::vector<float> getFreqs();
         juce::Rectangle<int> getRenderArea();
         juce::Rectangle<int> getAnalysisArea();
-        void updateMagnitudes (std::vector<double>& magnitudes, int width);
+        void updateFrequencyTable(int width);
+        void updateBandMagnitudes(Band band);
+        void updateResponseCurve();
 
         //void updateMagnitudeByCutCoefficients(double& mag, CoefficientsArray cutCoefficients);
 };
 
+// DSP load of the last metering window over the response curve, click to reset the worst case
+struct DspLoadOverlay : juce::Component {
+    public:
+        DspLoadOverlay(SimpleEQAudioProcessor&);
+
+        // returns true if the processor published a new window since the last call
+        bool update();
+
+    private:
+        SimpleEQAudioProcessor& audioProcessor;
+        DspLoadSnapshot load;
+        uint32_t displayedVersion = 0;
+
+        void paint(juce::Graphics& g) override;
+        void mouseDown(const juce::MouseEvent&) override;
+};
+
 //==============================================================================
 /**
 */
 class SimpleEQAudioProcessorEditor : public juce::AudioProcessorEditor,
-                                            juce::AudioProcessorParameter::Listener,
                                             juce::Timer
 {
 public:
@@ -101,16 +153,14 @@ private:
     void paint(juce::Graphics&) override;
     void resized() override;
 
-    void parameterValueChanged(int parameterIndex, float newValue) override;
-    void parameterGestureChanged(int parameterIndex, bool gestureIsStarting) override;
-
     void timerCallback() override;
 
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
     SimpleEQAudioProcessor& audioProcessor;
 
-    juce::Atomic<bool> parametersChanged { false };
+    // snapshot version the response curve was last built from
+    uint32_t displayedSettingsVersion = 0;
 
     RotarySliderWithLabels lowCutFreqSlider,
         highCutFreqSlider,
@@ -118,20 +168,53 @@ private:
         peakFilterGainSlider,
         peakFilterFreqSlider,
         lowCutSlopeSlider,
-        highCutSlopeSlider;
+        highCutSlopeSlider,
+        dynamicThresholdSlider,
+        dynamicRatioSlider,
+        dynamicAttackSlider,
+        dynamicReleaseSlider;
 
     using SliderAttachment = juce::AudioProcessorValueTreeState::SliderAttachment;
+    using ComboBoxAttachment = juce::AudioProcessorValueTreeState::ComboBoxAttachment;
+    using ButtonAttachment = juce::AudioProcessorValueTreeState::ButtonAttachment;
 
     SliderAttachment lowCutSlopeSliderAttachment,
                     lowCutFreqSliderAttachment,
-                    peakFilterQualitySliderAttachment,
-                    peakFilterGainSliderAttachment,
-                    peakFilterFreqSliderAttachment,
                     highCutSlopeSliderAttachment,
                     highCutFreqSliderAttachment;
 
+    // the peak sliders, on / off and type show the selected band, their attachments are made again for every band
+    juce::ComboBox bandSelector, bandTypeComboBox, bandChannelComboBox;
+    juce::ToggleButton bandEnabledButton { "On" }, bandDynamicButton { "Dynamic" };
+
+    std::unique_ptr<SliderAttachment> peakFilterQualitySliderAttachment,
+                                      peakFilterGainSliderAttachment,
+                                      peakFilterFreqSliderAttachment,
+                                      dynamicThresholdSliderAttachment,
+                                      dynamicRatioSliderAttachment,
+                                      dynamicAttackSliderAttachment,
+                                      dynamicReleaseSliderAttachment;
+    std::unique_ptr<ComboBoxAttachment> bandTypeAttachment, bandChannelAttachment;
+    std::unique_ptr<ButtonAttachment> bandEnabledAttachment, bandDynamicAttachment;
+
+    // what every dynamic bell listens to, not per band
+    juce::ComboBox dynamicSourceComboBox;
+    std::unique_ptr<ComboBoxAttachment> dynamicSourceAttachment;
+
+    // Linked, Left/Right or Mid/Side; the band's channel only counts in the latter two
+    juce::ComboBox stereoModeComboBox;
+    std::unique_ptr<ComboBoxAttachment> stereoModeAttachment;
+
+    void selectBand(int band);
+
+    // the dynamics only apply to bells with dynamic switched on
+    void updateDynamicControls();
+
     ResponseCurveComponent responseCurveComponent;
 
+    DspLoadOverlay dspLoadOverlay;
+    juce::ToggleButton dspLoadButton { "DSP Load" };
+
     //struct ResponseCurveComponent : juce::Component, juce::AudioProcessorParameter::Listener, juce::Timer 
     //{
     //    ResponseCurveComponent(SimpleEQAudioProcessor&);
@@ -7,32 +7,392 @@
 */
 
 #include "PluginProcessor.h"
-#include "PluginEditor.h"
+#include "RealtimeChecks.h"
+#if ! SIMPLEEQ_HEADLESS
+ #include "PluginEditor.h"
+#endif
+
+int getNumLowCutSections(const ChainSettings& chainSettings)
+{
+    return chainSettings.lowCutFreq <= 20.f ? 0 : chainSettings.lowCutSlope + 1;
+}
+
+int getNumHighCutSections(const ChainSettings& chainSettings)
+{
+    return chainSettings.highCutFreq >= 20000.f ? 0 : chainSettings.highCutSlope + 1;
+}
+
+bool isBandActive(const BandSettings& band)
+{
+    if (! band.enabled)
+        return false;
+
+    switch (band.type)
+    {
+        case BandType::Notch:
+        case BandType::HighPass:
+        case BandType::LowPass:
+            return true;
+
+        default:
+            return band.gainInDecibel != 0.f || band.isDynamicBell();
+    }
+}
+
+BandParameterIDs getBandParameterIDs(int band)
+{
+    const juce::String prefix = band == 0 ? juce::String("Peak") : "Band " + juce::String(band + 1);
+
+    return { prefix + " Enabled", prefix + " Type", prefix + " Freq", prefix + " Gain", prefix + " Quality", prefix + " Channel",
+             prefix + " Dynamic", prefix + " Threshold", prefix + " Ratio", prefix + " Attack", prefix + " Release" };
+}
+
+// order of the values in the binary state. This is the version 1 layout: new parameters are only
+// ever appended, never inserted or reordered.
+static juce::StringArray getStateParameterIDs()
+{
+    juce::StringArray ids { "LowCut Freq", "HighCut Freq", "LowCut Slope", "HighCut Slope" };
+
+    for (int band = 0; band < maxBands; ++band)
+    {
+        const auto bandIDs = getBandParameterIDs(band);
+
+        for (auto& id : { bandIDs.enabled, bandIDs.type, bandIDs.freq, bandIDs.gain, bandIDs.quality, bandIDs.channel,
+                          bandIDs.dynamic, bandIDs.threshold, bandIDs.ratio, bandIDs.attack, bandIDs.release })
+            ids.add(id);
+    }
+
+    for (auto* id : { "Smoothing", "Smoothing Interval", "Filter Engine", "Oversampling", "Phase Mode",
+                      "Precision", "Stereo Mode", "Dynamic Source", "Multithreading" })
+        ids.add(id);
+
+    return ids;
+}
+
+BiquadCoefficients makeBandCoefficients(const BandSettings& band, double sampleRate)
+{
+    switch (band.type)
+    {
+        case BandType::LowShelf:  return SosDesigner::designLowShelf(band.freq, band.quality, band.gainInDecibel, sampleRate);
+        case BandType::HighShelf: return SosDesigner::designHighShelf(band.freq, band.quality, band.gainInDecibel, sampleRate);
+        case BandType::Notch:     return SosDesigner::designNotch(band.freq, band.quality, sampleRate);
+        case BandType::Tilt:      return SosDesigner::designTilt(band.freq, band.quality, band.gainInDecibel, sampleRate);
+        case BandType::HighPass:  return SosDesigner::designHighPass(band.freq, band.quality, sampleRate);
+        case BandType::LowPass:   return SosDesigner::designLowPass(band.freq, band.quality, sampleRate);
+        case BandType::Bell:
+        default:                  return SosDesigner::designPeak(band.freq, band.quality, band.gainInDecibel, sampleRate);
+    }
+}
+
+SvfCoefficients makeSvfBandCoefficients(const BandSettings& band, double sampleRate)
+{
+    switch (band.type)
+    {
+        case BandType::LowShelf:  return SosDesigner::designSvfLowShelf(band.freq, band.quality, band.gainInDecibel, sampleRate);
+        case BandType::HighShelf: return SosDesigner::designSvfHighShelf(band.freq, band.quality, band.gainInDecibel, sampleRate);
+        case BandType::Notch:     return SosDesigner::designSvfNotch(band.freq, band.quality, sampleRate);
+        case BandType::Tilt:      return SosDesigner::designSvfTilt(band.freq, band.quality, band.gainInDecibel, sampleRate);
+        case BandType::HighPass:  return SosDesigner::designSvfHighPass(band.freq, band.quality, sampleRate);
+        case BandType::LowPass:   return SosDesigner::designSvfLowPass(band.freq, band.quality, sampleRate);
+        case BandType::Bell:
+        default:                  return SosDesigner::designSvfPeak(band.freq, band.quality, band.gainInDecibel, sampleRate);
+    }
+}
+
+ChainCoefficients makeChainCoefficients(const ChainSettings& chainSettings, double sampleRate, FilterEngine engine)
+{
+    ChainCoefficients chainCoefficients;
+
+    chainCoefficients.engine = engine;
+    chainCoefficients.sampleRate = sampleRate;
+    chainCoefficients.numLowCutSections = getNumLowCutSections(chainSettings);
+    chainCoefficients.numHighCutSections = getNumHighCutSections(chainSettings);
+    chainCoefficients.stereoMode = chainSettings.stereoMode;
+
+    // the processing list only holds the bands that change the signal
+    for (int band = 0; band < maxBands; ++band)
+    {
+        if (isBandActive(chainSettings.bands[(size_t)band]))
+            chainCoefficients.activeBands[(size_t)chainCoefficients.numActiveBands++] = band;
+
+        chainCoefficients.bandChannels[(size_t)band] = chainSettings.stereoMode == StereoMode::Linked ? BandChannel::BothChannels
+                                                                                                      : chainSettings.bands[(size_t)band].channel;
+    }
+
+    // dynamic bells keep their frequency dependent part for the audio thread
+    auto& dynamicBands = chainCoefficients.dynamicBands;
+
+    for (int i = 0; i < chainCoefficients.numActiveBands; ++i)
+    {
+        const auto& band = chainSettings.bands[(size_t)chainCoefficients.activeBands[(size_t)i]];
+
+        if (band.isDynamicBell())
+        {
+            const auto index = (size_t)dynamicBands.numBands++;
+
+            dynamicBands.bands[index] = chainCoefficients.activeBands[(size_t)i];
+            dynamicBands.prototypes[index] = SosDesigner::prepareBell(band.freq, band.quality, sampleRate);
+            dynamicBands.gainInDecibel[index] = band.gainInDecibel;
+            dynamicBands.channels[index] = chainCoefficients.bandChannels[(size_t)dynamicBands.bands[index]];
+        }
+    }
+
+    if (engine == FilterEngine::Svf)
+    {
+        for (int i = 0; i < chainCoefficients.numActiveBands; ++i)
+        {
+            const auto band = (size_t)chainCoefficients.activeBands[(size_t)i];
+            chainCoefficients.svfBands[band] = makeSvfBandCoefficients(chainSettings.bands[band], sampleRate);
+        }
+
+        SosDesigner::designSvfCut(chainCoefficients.svfLowCut.data(), chainCoefficients.numLowCutSections, chainSettings.lowCutFreq, sampleRate, true);
+        SosDesigner::designSvfCut(chainCoefficients.svfHighCut.data(), chainCoefficients.numHighCutSections, chainSettings.highCutFreq, sampleRate, false);
+    }
+    else
+    {
+        for (int i = 0; i < chainCoefficients.numActiveBands; ++i)
+        {
+            const auto band = (size_t)chainCoefficients.activeBands[(size_t)i];
+            chainCoefficients.bands[band] = makeBandCoefficients(chainSettings.bands[band], sampleRate);
+        }
+
+        SosDesigner::designCut(chainCoefficients.lowCut.data(), chainCoefficients.numLowCutSections, chainSettings.lowCutFreq, sampleRate, true);
+        SosDesigner::designCut(chainCoefficients.highCut.data(), chainCoefficients.numHighCutSections, chainSettings.highCutFreq, sampleRate, false);
+    }
 
-Coefficients makePeakFilter(const ChainSettings& chainSettings, double sampleRate)
+    return chainCoefficients;
+}
+
+//==============================================================================
+ChainSettingsSnapshot::ChainSettingsSnapshot(juce::AudioProcessorValueTreeState& apvts)
 {
-    return juce::dsp::IIR::Coefficients<float>::makePeakFilter(
-        sampleRate,
-        chainSettings.peakFreq,
-        chainSettings.peakQuality,
-        juce::Decibels::decibelsToGain(chainSettings.peakGainInDecibel));
+    parameters[LowCutFreq] = apvts.getRawParameterValue("LowCut Freq");
+    parameters[HighCutFreq] = apvts.getRawParameterValue("HighCut Freq");
+    parameters[LowCutSlope] = apvts.getRawParameterValue("LowCut Slope");
+    parameters[HighCutSlope] = apvts.getRawParameterValue("HighCut Slope");
+    parameters[Stereo] = apvts.getRawParameterValue("Stereo Mode");
+
+    for (int band = 0; band < maxBands; ++band)
+    {
+        const auto ids = getBandParameterIDs(band);
+
+        parameters[getBandValueIndex(band, Enabled)] = apvts.getRawParameterValue(ids.enabled);
+        parameters[getBandValueIndex(band, Type)] = apvts.getRawParameterValue(ids.type);
+        parameters[getBandValueIndex(band, Freq)] = apvts.getRawParameterValue(ids.freq);
+        parameters[getBandValueIndex(band, Gain)] = apvts.getRawParameterValue(ids.gain);
+        parameters[getBandValueIndex(band, Quality)] = apvts.getRawParameterValue(ids.quality);
+        parameters[getBandValueIndex(band, Channel)] = apvts.getRawParameterValue(ids.channel);
+        parameters[getBandValueIndex(band, Dynamic)] = apvts.getRawParameterValue(ids.dynamic);
+        parameters[getBandValueIndex(band, Threshold)] = apvts.getRawParameterValue(ids.threshold);
+        parameters[getBandValueIndex(band, Ratio)] = apvts.getRawParameterValue(ids.ratio);
+        parameters[getBandValueIndex(band, Attack)] = apvts.getRawParameterValue(ids.attack);
+        parameters[getBandValueIndex(band, Release)] = apvts.getRawParameterValue(ids.release);
+    }
+
+    for (auto* parameter : parameters)
+        jassert(parameter != nullptr);
+
+    publishIfDirty();
 }
 
-CoefficientsArray makeLowCutFilter(const ChainSettings& chainSettings, double sampleRate)
+void ChainSettingsSnapshot::beginUpdate() noexcept
 {
-    return juce::dsp::FilterDesign<float>::designIIRHighpassHighOrderButterworthMethod(
-        chainSettings.lowCutFreq,
-        sampleRate,
-        2 * (chainSettings.lowCutSlope + 1));
+    // sequentially consistent together with publishIfDirty: either the publisher sees the hold
+    // or this sees the publish in progress and waits for it
+    isHeld.store(true);
+
+    // a publish that started before the hold finishes with the old values
+    while (isPublishing.load())
+        juce::Thread::yield();
 }
 
+void ChainSettingsSnapshot::endUpdate() noexcept
+{
+    isHeld.store(false, std::memory_order_release);
+    markDirty();
+}
 
-CoefficientsArray makeHighCutFilter(const ChainSettings& chainSettings, double sampleRate)
+void ChainSettingsSnapshot::publishIfDirty() noexcept
 {
-    return juce::dsp::FilterDesign<float>::designIIRLowpassHighOrderButterworthMethod(
-        chainSettings.highCutFreq,
-        sampleRate,
-        2 * (chainSettings.highCutSlope + 1));
+    if (isHeld.load(std::memory_order_acquire) || ! dirty.load(std::memory_order_acquire))
+        return;
+
+    if (isPublishing.exchange(true))
+        return;
+
+    // the hold may have started between the check above and taking the publish
+    if (isHeld.load())
+    {
+        isPublishing.store(false, std::memory_order_release);
+        return;
+    }
+
+    if (dirty.exchange(false, std::memory_order_acq_rel))
+    {
+        const auto start = sequence.load(std::memory_order_relaxed);
+
+        sequence.store(start + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (int i = 0; i < NumValues; ++i)
+            values[(size_t)i].store(parameters[(size_t)i]->load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+        sequence.store(start + 2, std::memory_order_release);
+    }
+
+    isPublishing.store(false, std::memory_order_release);
+}
+
+bool ChainSettingsSnapshot::tryRead(ChainSettings& chainSettings, uint32_t& version) const noexcept
+{
+    const auto before = sequence.load(std::memory_order_acquire);
+
+    if ((before & 1) != 0)
+        return false;
+
+    ChainSettings settings;
+    settings.lowCutFreq = values[LowCutFreq].load(std::memory_order_relaxed);
+    settings.highCutFreq = values[HighCutFreq].load(std::memory_order_relaxed);
+    settings.lowCutSlope = static_cast<FilterSlope>((int)values[LowCutSlope].load(std::memory_order_relaxed));
+    settings.highCutSlope = static_cast<FilterSlope>((int)values[HighCutSlope].load(std::memory_order_relaxed));
+    settings.stereoMode = static_cast<StereoMode>((int)values[Stereo].load(std::memory_order_relaxed));
+
+    for (int i = 0; i < maxBands; ++i)
+    {
+        auto& band = settings.bands[(size_t)i];
+
+        band.enabled = values[getBandValueIndex(i, Enabled)].load(std::memory_order_relaxed) > 0.5f;
+        band.type = static_cast<BandType>((int)values[getBandValueIndex(i, Type)].load(std::memory_order_relaxed));
+        band.freq = values[getBandValueIndex(i, Freq)].load(std::memory_order_relaxed);
+        band.gainInDecibel = values[getBandValueIndex(i, Gain)].load(std::memory_order_relaxed);
+        band.quality = values[getBandValueIndex(i, Quality)].load(std::memory_order_relaxed);
+        band.channel = static_cast<BandChannel>((int)values[getBandValueIndex(i, Channel)].load(std::memory_order_relaxed));
+        band.dynamic = values[getBandValueIndex(i, Dynamic)].load(std::memory_order_relaxed) > 0.5f;
+        band.thresholdInDecibel = values[getBandValueIndex(i, Threshold)].load(std::memory_order_relaxed);
+        band.ratio = values[getBandValueIndex(i, Ratio)].load(std::memory_order_relaxed);
+        band.attackMs = values[getBandValueIndex(i, Attack)].load(std::memory_order_relaxed);
+        band.releaseMs = values[getBandValueIndex(i, Release)].load(std::memory_order_relaxed);
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    if (sequence.load(std::memory_order_relaxed) != before)
+        return false;
+
+    chainSettings = settings;
+    version = before;
+    return true;
+}
+
+ChainSettings ChainSettingsSnapshot::read() const noexcept
+{
+    ChainSettings settings;
+    uint32_t version;
+
+    while (! tryRead(settings, version))
+        juce::Thread::yield();
+
+    return settings;
+}
+
+//==============================================================================
+void SmoothedChainSettings::reset(double sampleRate, double rampLengthInSeconds)
+{
+    for (auto& band : bands)
+    {
+        band.freq.reset(sampleRate, rampLengthInSeconds);
+        band.quality.reset(sampleRate, rampLengthInSeconds);
+        band.gainInDecibel.reset(sampleRate, rampLengthInSeconds);
+    }
+
+    lowCutFreq.reset(sampleRate, rampLengthInSeconds);
+    highCutFreq.reset(sampleRate, rampLengthInSeconds);
+}
+
+void SmoothedChainSettings::setCurrentAndTargetValue(const ChainSettings& chainSettings)
+{
+    for (size_t i = 0; i < bands.size(); ++i)
+    {
+        auto& band = bands[i];
+        const auto& target = chainSettings.bands[i];
+
+        band.freq.setCurrentAndTargetValue(target.freq);
+        band.quality.setCurrentAndTargetValue(target.quality);
+        band.gainInDecibel.setCurrentAndTargetValue(target.gainInDecibel);
+        band.target = target;
+    }
+
+    lowCutFreq.setCurrentAndTargetValue(chainSettings.lowCutFreq);
+    highCutFreq.setCurrentAndTargetValue(chainSettings.highCutFreq);
+    lowCutSlope = chainSettings.lowCutSlope;
+    highCutSlope = chainSettings.highCutSlope;
+    stereoMode = chainSettings.stereoMode;
+}
+
+bool SmoothedChainSettings::setTargetValue(const ChainSettings& chainSettings)
+{
+    bool changed = lowCutFreq.getTargetValue() != chainSettings.lowCutFreq
+                || highCutFreq.getTargetValue() != chainSettings.highCutFreq
+                || lowCutSlope != chainSettings.lowCutSlope
+                || highCutSlope != chainSettings.highCutSlope
+                || stereoMode != chainSettings.stereoMode;
+
+    lowCutFreq.setTargetValue(chainSettings.lowCutFreq);
+    highCutFreq.setTargetValue(chainSettings.highCutFreq);
+    lowCutSlope = chainSettings.lowCutSlope;
+    highCutSlope = chainSettings.highCutSlope;
+    stereoMode = chainSettings.stereoMode;
+
+    for (size_t i = 0; i < bands.size(); ++i)
+    {
+        auto& band = bands[i];
+        const auto& target = chainSettings.bands[i];
+
+        changed = changed || band.target != target;
+
+        band.freq.setTargetValue(target.freq);
+        band.quality.setTargetValue(target.quality);
+        band.gainInDecibel.setTargetValue(target.gainInDecibel);
+        band.target = target;
+    }
+
+    return changed;
+}
+
+bool SmoothedChainSettings::isSmoothing() const noexcept
+{
+    if (lowCutFreq.isSmoothing() || highCutFreq.isSmoothing())
+        return true;
+
+    for (const auto& band : bands)
+        if (band.freq.isSmoothing() || band.quality.isSmoothing() || band.gainInDecibel.isSmoothing())
+            return true;
+
+    return false;
+}
+
+ChainSettings SmoothedChainSettings::getNextValues(int numSamples) noexcept
+{
+    ChainSettings settings;
+
+    for (size_t i = 0; i < bands.size(); ++i)
+    {
+        auto& band = bands[i];
+        auto& values = settings.bands[i];
+
+        values = band.target;
+        values.freq = band.freq.skip(numSamples);
+        values.quality = band.quality.skip(numSamples);
+        values.gainInDecibel = band.gainInDecibel.skip(numSamples);
+    }
+
+    settings.lowCutFreq = lowCutFreq.skip(numSamples);
+    settings.highCutFreq = highCutFreq.skip(numSamples);
+    settings.lowCutSlope = lowCutSlope;
+    settings.highCutSlope = highCutSlope;
+    settings.stereoMode = stereoMode;
+
+    return settings;
 }
 
 //==============================================================================
@@ -42,16 +402,48 @@ SimpleEQAudioProcessor::SimpleEQAudioProcessor()
                      #if ! JucePlugin_IsMidiEffect
                       #if ! JucePlugin_IsSynth
                        .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
+                       .withInput  ("Sidechain", juce::AudioChannelSet::stereo(), false)
                       #endif
                        .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
                      #endif
                        )
 #endif
 {
+    for (auto* param : getParameters())
+        if (auto* paramWithID = dynamic_cast<juce::AudioProcessorParameterWithID*>(param))
+            apvts.addParameterListener(paramWithID->paramID, this);
+
+    smoothingParam = apvts.getRawParameterValue("Smoothing");
+    smoothingIntervalParam = apvts.getRawParameterValue("Smoothing Interval");
+    engineParam = apvts.getRawParameterValue("Filter Engine");
+    oversamplingParam = apvts.getRawParameterValue("Oversampling");
+    precisionParam = apvts.getRawParameterValue("Precision");
+    phaseModeParam = apvts.getRawParameterValue("Phase Mode");
+    dynamicSourceParam = apvts.getRawParameterValue("Dynamic Source");
+    multithreadingParam = apvts.getRawParameterValue("Multithreading");
+
+    for (auto& parameterID : getStateParameterIDs())
+    {
+        auto* parameter = apvts.getParameter(parameterID);
+        jassert(parameter != nullptr);
+
+        stateParameters.push_back(parameter);
+    }
+
+    // a parameter missing from getStateParameterIDs() would not be saved
+    jassert(stateParameters.size() == (size_t)getParameters().size());
+
+    coefficientThread->addTimeSliceClient(this);
 }
 
 SimpleEQAudioProcessor::~SimpleEQAudioProcessor()
 {
+    coefficientThread->removeTimeSliceClient(this);
+    detachLaneGroupWorkers();
+
+    for (auto* param : getParameters())
+        if (auto* paramWithID = dynamic_cast<juce::AudioProcessorParameterWithID*>(param))
+            apvts.removeParameterListener(paramWithID->paramID, this);
 }
 
 //==============================================================================
@@ -89,6 +481,12 @@ bool SimpleEQAudioProcessor::isMidiEffect() const
 
 double SimpleEQAudioProcessor::getTailLengthSeconds() const
 {
+    // the linear phase kernel rings for its whole length, the IIR cascades decay within a block
+    const double sampleRate = hostSampleRate.load();
+
+    if (phaseModeParam->load() > 0.5f && sampleRate > 0.0)
+        return LinearPhaseKernel::getKernelLength(sampleRate) / sampleRate;
+
     return 0.0;
 }
 
@@ -122,22 +520,180 @@ void SimpleEQAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlo
     // Use this method as the place to do any pre-playback
     // initialisation that you need
 
-    juce::dsp::ProcessSpec spec;
+    // workers may still be on copies of the previous layout, they are sized again below
+    detachLaneGroupWorkers();
+
+    // enough lane groups for every channel of the current layout, the sidechain only feeds the detectors
+    const int numChannels = juce::jmin(maxNumChannels, juce::jmax(getMainBusNumInputChannels(), getMainBusNumOutputChannels()));
+    const size_t numGroups = (size_t)((numChannels + numLanes - 1) / numLanes);
+    const size_t numDoubleGroups = (size_t)((numChannels + numDoubleLanes - 1) / numDoubleLanes);
+
+    biquadCascades.resize(numGroups);
+    svfCascades.resize(numGroups);
+    doubleBiquadCascades.resize(numDoubleGroups);
+    doubleSvfCascades.resize(numDoubleGroups);
+
+    // the workers take the lane groups after the first, which the audio thread does itself
+    {
+        const juce::ScopedLock lock(laneGroupWorkersLock);
+
+        numLaneGroups = (int)juce::jmax(numGroups, numDoubleGroups);
+        maxCascadeSamples = samplesPerBlock * 4; // room for 4x oversampling
+    }
+
+    updateLaneGroupWorkers();
+
+    resetCascades(biquadCascades);
+    resetCascades(svfCascades);
+    resetCascades(doubleBiquadCascades);
+    resetCascades(doubleSvfCascades);
+    currentEngine = static_cast<FilterEngine>((int)engineParam->load());
+
+    const bool hostUsesDouble = isUsingDoublePrecision();
+    useDoublePrecisionCascades = hostUsesDouble || precisionParam->load() > 0.5f;
+
+    // polyphase IIR half-band stages with integer latency, so it can be reported to the host exactly,
+    // in the host's precision
+    for (size_t i = 0; i < oversamplers.size(); ++i)
+    {
+        oversamplers[i].reset();
+        doubleOversamplers[i].reset();
+
+        if (hostUsesDouble)
+        {
+            doubleOversamplers[i] = std::make_unique<juce::dsp::Oversampling<double>>((size_t)juce::jmax(1, numChannels), i + 1,
+                                                                                       juce::dsp::Oversampling<double>::filterHalfBandPolyphaseIIR,
+                                                                                       true, true);
+            doubleOversamplers[i]->initProcessing((size_t)samplesPerBlock);
+            oversamplingLatencies[i + 1] = (int)doubleOversamplers[i]->getLatencyInSamples();
+        }
+        else
+        {
+            oversamplers[i] = std::make_unique<juce::dsp::Oversampling<float>>((size_t)juce::jmax(1, numChannels), i + 1,
+                                                                               juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR,
+                                                                               true, true);
+            oversamplers[i]->initProcessing((size_t)samplesPerBlock);
+            oversamplingLatencies[i + 1] = (int)oversamplers[i]->getLatencyInSamples();
+        }
+    }
 
-    spec.sampleRate = sampleRate;
-    spec.numChannels = 1;
-    spec.maximumBlockSize = samplesPerBlock;
+    // conversion buffers: double copies for mixed precision (room for 4x oversampling),
+    // float copies for the convolution of a double precision host
+    doubleScratch.setSize(hostUsesDouble ? 0 : numChannels, hostUsesDouble ? 0 : samplesPerBlock * 4);
+    floatScratch.setSize(hostUsesDouble ? numChannels : 0, hostUsesDouble ? samplesPerBlock : 0);
 
-    leftChain.prepare(spec);
-    rightChain.prepare(spec);
+    isLinearPhase = phaseModeParam->load() > 0.5f;
+    currentOversampling = isLinearPhase ? 0 : juce::jlimit(0, 2, (int)oversamplingParam->load());
+    hostSampleRate.store(sampleRate);
 
+    {
+        const juce::ScopedLock lock(convolutionLock);
+
+        convolutions.clear();
+
+        for (int ch = 0; ch < numChannels; ch += 2)
+        {
+            auto convolution = std::make_unique<juce::dsp::Convolution>(juce::dsp::Convolution::NonUniform { 512 }, convolutionQueue);
+            convolution->prepare({ sampleRate, (juce::uint32)samplesPerBlock, 2 });
+            convolutions.push_back(std::move(convolution));
+        }
+
+        linearPhaseLatency.store(LinearPhaseKernel::getLatency(sampleRate) + (convolutions.empty() ? 0 : convolutions.front()->getLatency()));
+    }
+
+    updateLatency();
+
+    const double processingSampleRate = sampleRate * (1 << currentOversampling);
+
+    smoothedSettings.reset(processingSampleRate, smoothingRampSeconds);
+    chainSettingsSnapshot.publishIfDirty();
+    audioThreadSettings = chainSettingsSnapshot.read();
+    audioThreadSettingsVersion = chainSettingsSnapshot.getVersion();
+    smoothedSettings.setCurrentAndTargetValue(audioThreadSettings);
+
+    dynamicEq.prepare(sampleRate, samplesPerBlock, maxBands);
+    updateDynamicEq(audioThreadSettings);
+
+    silentInputSamples = 0;
+    isIdleOnSilence = false;
+    processingState.store(Processing);
+    dspLoadMeter.prepare(sampleRate);
+
+    // the kernel length depends on the sample rate, so load a fresh one before playback starts. In minimum
+    // phase it stays dirty, and the coefficient thread loads it once linear phase is selected. Cleared
+    // before the coefficient thread sees the sample rate, so it doesn't load a second one.
+    kernelDirty.store(! isLinearPhase);
+
+    currentSampleRate.store(processingSampleRate);
+    preEqFifo.setSampleRate(sampleRate);
+    postEqFifo.setSampleRate(sampleRate);
     updateFilters();
+
+    if (isLinearPhase)
+        loadLinearPhaseKernel(audioThreadSettings);
 }
 
 void SimpleEQAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+    detachLaneGroupWorkers();
+}
+
+void SimpleEQAudioProcessor::updateLaneGroupWorkers()
+{
+    const juce::ScopedLock lock(laneGroupWorkersLock);
+
+    if (multithreadingParam->load() <= 0.5f || numLaneGroups < 2 || laneGroupWorkersReady.load())
+        return;
+
+    if (laneGroupCopySamples < maxCascadeSamples)
+    {
+        allocateLaneGroupCopies(biquadCopies, biquadCascades.size(), maxCascadeSamples);
+        allocateLaneGroupCopies(svfCopies, svfCascades.size(), maxCascadeSamples);
+        allocateLaneGroupCopies(doubleBiquadCopies, doubleBiquadCascades.size(), maxCascadeSamples);
+        allocateLaneGroupCopies(doubleSvfCopies, doubleSvfCascades.size(), maxCascadeSamples);
+        laneGroupCopySamples = maxCascadeSamples;
+    }
+
+    // false on a single core, then everything stays on the audio thread
+    if (laneGroupWorkers->attach(laneGroupJob))
+    {
+        numLaneGroupWorkers = laneGroupWorkers->getNumWorkers();
+        laneGroupWorkersReady.store(true, std::memory_order_release);
+    }
+}
+
+void SimpleEQAudioProcessor::detachLaneGroupWorkers()
+{
+    const juce::ScopedLock lock(laneGroupWorkersLock);
+
+    laneGroupWorkersReady.store(false);
+    laneGroupWorkers->detach(laneGroupJob);
+    numLaneGroups = 0;
+    laneGroupCopySamples = 0; // sized for the next layout when the workers are used again
+}
+
+void SimpleEQAudioProcessor::reset()
+{
+    resetActiveCascades();
+
+    for (size_t i = 0; i < oversamplers.size(); ++i)
+    {
+        if (oversamplers[i] != nullptr)
+            oversamplers[i]->reset();
+
+        if (doubleOversamplers[i] != nullptr)
+            doubleOversamplers[i]->reset();
+    }
+
+    for (auto& convolution : convolutions)
+        convolution->reset();
+
+    dynamicEq.reset();
+
+    silentInputSamples = 0;
+    isIdleOnSilence = false;
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -147,18 +703,21 @@ bool SimpleEQAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts)
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Any layout from mono up to 16 channels (e.g. stereo, 5.1, 7.1.4,
+    // third order ambisonics), every channel gets the same EQ.
+    const int numChannels = layouts.getMainOutputChannelSet().size();
+
+    if (numChannels < 1 || numChannels > maxNumChannels)
         return false;
 
     // This checks if the input layout matches the output layout
    #if ! JucePlugin_IsSynth
     if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
         return false;
+
+    // the sidechain is mixed down to mono for the dynamic bands, mono or stereo (or off) will do
+    if (layouts.inputBuses.size() > 1 && layouts.getChannelSet(true, 1).size() > 2)
+        return false;
    #endif
 
     return true;
@@ -167,10 +726,41 @@ bool SimpleEQAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts)
 #endif
 
 void SimpleEQAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+   #if SIMPLEEQ_RT_CHECKS
+    const RealtimeChecks::ScopedAudioCallback realtimeChecks;
+   #endif
+
+    const DspLoadMeter::ScopedMeasurement loadMeasurement(dspLoadMeter, buffer.getNumSamples());
+    processBlockInternal(buffer);
+}
+
+void SimpleEQAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+   #if SIMPLEEQ_RT_CHECKS
+    const RealtimeChecks::ScopedAudioCallback realtimeChecks;
+   #endif
+
+    const DspLoadMeter::ScopedMeasurement loadMeasurement(dspLoadMeter, buffer.getNumSamples());
+    processBlockInternal(buffer);
+}
+
+template <typename SampleType>
+static bool isSilent(const juce::AudioBuffer<SampleType>& buffer, int numChannels) noexcept
+{
+    for (int ch = 0; ch < numChannels; ++ch)
+        if (buffer.getMagnitude(ch, 0, buffer.getNumSamples()) > (SampleType)SimpleEQAudioProcessor::silenceThreshold)
+            return false;
+
+    return true;
+}
+
+template <typename SampleType>
+void SimpleEQAudioProcessor::processBlockInternal(juce::AudioBuffer<SampleType>& buffer)
 {
     juce::ScopedNoDenormals noDenormals;
-    auto totalNumInputChannels  = getTotalNumInputChannels();
-    auto totalNumOutputChannels = getTotalNumOutputChannels();
+    auto totalNumInputChannels  = getMainBusNumInputChannels();
+    auto totalNumOutputChannels = getMainBusNumOutputChannels();
 
     // In case we have more outputs than inputs, this code clears any output
     // channels that didn't contain input data, (because these aren't
@@ -181,111 +771,673 @@ void SimpleEQAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juc
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
 
-    SimpleEQAudioProcessor::updateFilters();
+    // channels run through the cascades in groups, one channel per SIMD lane
+    const int numChannels = juce::jmin(totalNumInputChannels, (int)biquadCascades.size() * numLanes);
+
+    // only a mono mix-down into a FIFO, the analysis itself runs on the editor's analyser thread
+    const bool feedAnalyzer = analyzerEnabled.load(std::memory_order_relaxed);
+
+    if (feedAnalyzer)
+        preEqFifo.push(buffer.getArrayOfReadPointers(), numChannels, buffer.getNumSamples());
+
+    // only pick up coefficients when the background thread has published new ones
+    const bool hasNewCoefficients = coefficientBuffer.pull();
+    const bool settingsChanged = updateAudioThreadSettings();
+    const bool isSmoothing = smoothingParam->load() > 0.5f;
+
+    if (settingsChanged)
+        updateDynamicEq(audioThreadSettings);
+
+    // the newly selected engine or oversampling factor starts from silence with coefficients designed right here
+    const auto engine = static_cast<FilterEngine>((int)engineParam->load());
+    const bool engineChanged = engine != currentEngine;
+
+    const bool linearPhase = phaseModeParam->load() > 0.5f;
+    const bool phaseModeChanged = linearPhase != isLinearPhase;
+
+    if (phaseModeChanged)
+    {
+        isLinearPhase = linearPhase;
+
+        for (auto& convolution : convolutions)
+            convolution->reset();
+    }
+
+    const int oversampling = linearPhase ? 0 : juce::jlimit(0, 2, (int)oversamplingParam->load());
+    const bool oversamplingChanged = oversampling != currentOversampling;
+
+    if (oversamplingChanged)
+    {
+        currentOversampling = oversampling;
+        currentSampleRate.store(hostSampleRate.load() * (1 << currentOversampling));
+
+        smoothedSettings.reset(currentSampleRate.load(), smoothingRampSeconds);
+
+        if (auto* oversampler = getOversampler<SampleType>())
+            oversampler->reset();
+    }
+
+    // the workers are started off the audio thread, switching the parameter on takes effect once they run
+    processInParallel = multithreadingParam->load() > 0.5f && laneGroupWorkersReady.load(std::memory_order_acquire);
+
+    // a double precision host always gets double cascades, "Double" also runs them for float hosts
+    const bool doublePrecision = std::is_same<SampleType, double>::value || precisionParam->load() > 0.5f;
+    const bool precisionChanged = doublePrecision != useDoublePrecisionCascades;
+
+    const bool needsDesign = engineChanged || oversamplingChanged || phaseModeChanged || precisionChanged;
+
+    if (needsDesign)
+    {
+        currentEngine = engine;
+        useDoublePrecisionCascades = doublePrecision;
+        resetActiveCascades();
+    }
+
+    // idle with nothing new to apply: on a silent input once every tail has decayed, or with settings that
+    // leave the signal untouched (no active section, no oversampling or linear phase latency to keep)
+    const bool inputIsSilent = isSilent(buffer, numChannels);
+    silentInputSamples = inputIsSilent ? silentInputSamples + buffer.getNumSamples() : 0;
+
+    const bool canIdle = ! settingsChanged && ! hasNewCoefficients && ! needsDesign
+                      && ! (isSmoothing && smoothedSettings.isSmoothing());
+    const bool isTransparent = canIdle && chainIsTransparent && ! isLinearPhase && currentOversampling == 0;
+
+    isIdleOnSilence = isIdleOnSilence && inputIsSilent;
+
+    if (isTransparent || (canIdle && isIdleOnSilence))
+    {
+        processingState.store(isTransparent ? TransparentSettings : SilentInput, std::memory_order_relaxed);
+
+        if (feedAnalyzer)
+            postEqFifo.push(buffer.getArrayOfReadPointers(), numChannels, buffer.getNumSamples());
+
+        return;
+    }
+
+    processingState.store(Processing, std::memory_order_relaxed);
+
+    auto block = juce::dsp::AudioBlock<SampleType>(buffer).getSubsetChannelBlock(0, (size_t)numChannels);
+
+    if (isLinearPhase)
+    {
+        // the coefficient thread keeps the kernel up to date, only hand the cascade design back to it
+        if (needsDesign || wasSmoothing)
+            coefficientsDirty.store(true);
+
+        processLinearPhase(block);
+
+        wasSmoothing = false;
+        updateIdleOnSilence(buffer, numChannels);
+
+        if (feedAnalyzer)
+            postEqFifo.push(buffer.getArrayOfReadPointers(), numChannels, buffer.getNumSamples());
+
+        return;
+    }
+
+    // level detection for the dynamic bells on the host rate input, or on the sidechain when selected and connected.
+    // Runs without dynamic bands as well, which leaves no gain offsets behind for a design still in flight.
+    const bool useSidechain = dynamicEq.hasDynamicBands() && dynamicSourceParam->load() > 0.5f
+                           && getBusCount(true) > 1 && getChannelCountOfBus(true, 1) > 0;
+
+    if (useSidechain)
+    {
+        auto sidechain = getBusBuffer(buffer, true, 1);
+        dynamicEq.process(sidechain.getArrayOfReadPointers(), sidechain.getNumChannels(), sidechain.getNumSamples());
+    }
+    else
+    {
+        dynamicEq.process(buffer.getArrayOfReadPointers(), numChannels, buffer.getNumSamples());
+    }
+
+    dynamicPosition = 0;
+    dynamicCoefficientsStale = true;
+
+    // the cascades run on the oversampled block, or in place on the host buffer
+    auto* oversampler = numChannels > 0 ? getOversampler<SampleType>() : nullptr;
+    auto processingBlock = oversampler != nullptr ? oversampler->processSamplesUp(block) : block;
+
+    SampleType* channels[maxNumChannels];
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        channels[ch] = processingBlock.getChannelPointer((size_t)ch);
+
+    const int numSamples = (int)processingBlock.getNumSamples();
 
-    juce::dsp::AudioBlock<float> block(buffer);
+    if (isSmoothing)
+    {
+        // the ramps start at the current settings, which the background design may not have reached yet
+        if (! wasSmoothing)
+            smoothedSettings.setCurrentAndTargetValue(audioThreadSettings);
+
+        processSmoothed(channels, numChannels, numSamples, settingsChanged, needsDesign || ! wasSmoothing);
+    }
+    else
+    {
+        // the background thread takes over again with the current parameters
+        if (wasSmoothing || needsDesign)
+            coefficientsDirty.store(true);
+
+        if (needsDesign)
+            applyCoefficients(makeChainCoefficients(audioThreadSettings, currentSampleRate.load(), currentEngine));
+        else if (hasNewCoefficients)
+            applyCoefficients(coefficientBuffer.getReadBuffer());
+
+        processFiltersWithDynamics(channels, numChannels, numSamples);
+    }
+
+    if (oversampler != nullptr)
+        oversampler->processSamplesDown(block);
+
+    wasSmoothing = isSmoothing;
+    updateIdleOnSilence(buffer, numChannels);
+
+    if (feedAnalyzer)
+        postEqFifo.push(buffer.getArrayOfReadPointers(), numChannels, buffer.getNumSamples());
+}
+
+template <typename SampleType>
+void SimpleEQAudioProcessor::updateIdleOnSilence(const juce::AudioBuffer<SampleType>& buffer, int numChannels) noexcept
+{
+    // the whole output block comes from silent input (latency included) and is silent itself, so every
+    // filter tail has decayed below the threshold: clear what is left and idle until the input returns
+    if (silentInputSamples < (juce::int64)getLatencySamples() + buffer.getNumSamples() || ! isSilent(buffer, numChannels))
+        return;
+
+    resetActiveCascades();
+
+    if (auto* oversampler = getOversampler<SampleType>())
+        oversampler->reset();
+
+    for (auto& convolution : convolutions)
+        convolution->reset();
+
+    dynamicEq.reset();
+    isIdleOnSilence = true;
+}
+
+bool SimpleEQAudioProcessor::updateAudioThreadSettings() noexcept
+{
+    chainSettingsSnapshot.publishIfDirty();
+
+    // nothing to do while the version hasn't moved; a publish in progress is picked up next block
+    if (chainSettingsSnapshot.getVersion() == audioThreadSettingsVersion)
+        return false;
+
+    return chainSettingsSnapshot.tryRead(audioThreadSettings, audioThreadSettingsVersion);
+}
+
+template <typename SampleType>
+void SimpleEQAudioProcessor::processSmoothed(SampleType* const* channels, int numChannels, int numSamples, bool settingsChanged, bool forceDesign)
+{
+    const int smoothingIntervals[] = { 16, 32, 64 };
+    const int interval = smoothingIntervals[juce::jlimit(0, 2, (int)smoothingIntervalParam->load())];
+
+    bool needsDesign = forceDesign;
 
-    auto leftBlock = block.getSingleChannelBlock(0);
-    auto rightBlock = block.getSingleChannelBlock(1);
+    if (settingsChanged)
+        needsDesign = smoothedSettings.setTargetValue(audioThreadSettings) || needsDesign;
 
-    juce::dsp::ProcessContextReplacing<float> leftContext(leftBlock);
-    juce::dsp::ProcessContextReplacing<float> rightContext(rightBlock);
+    SampleType* subBlockChannels[maxNumChannels];
 
-    leftChain.process(leftContext);
-    rightChain.process(rightContext);
-    
+    for (int offset = 0; offset < numSamples;)
+    {
+        // once the ramps have arrived the coefficients hold still, so the rest of the block goes in one call
+        const bool isRamping = needsDesign || smoothedSettings.isSmoothing();
+        const int numSubBlockSamples = isRamping ? juce::jmin(interval, numSamples - offset) : numSamples - offset;
+
+        if (isRamping)
+        {
+            applyCoefficients(makeChainCoefficients(smoothedSettings.getNextValues(numSubBlockSamples),
+                                                    currentSampleRate.load(),
+                                                    currentEngine));
+            needsDesign = false;
+        }
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            subBlockChannels[ch] = channels[ch] + offset;
+
+        processFiltersWithDynamics(subBlockChannels, numChannels, numSubBlockSamples);
+        offset += numSubBlockSamples;
+    }
+}
+
+void SimpleEQAudioProcessor::updateDynamicEq(const ChainSettings& chainSettings) noexcept
+{
+    for (int i = 0; i < maxBands; ++i)
+    {
+        const auto& band = chainSettings.bands[(size_t)i];
+
+        if (band.enabled && band.isDynamicBell())
+        {
+            const DynamicEq::BandParameters parameters { band.freq, band.quality, band.thresholdInDecibel,
+                                                         band.ratio, band.attackMs, band.releaseMs };
+            dynamicEq.setBand(i, &parameters);
+        }
+        else
+        {
+            dynamicEq.setBand(i, nullptr);
+        }
+    }
+}
+
+template <typename SampleType>
+void SimpleEQAudioProcessor::processFiltersWithDynamics(SampleType* const* channels, int numChannels, int numSamples)
+{
+    if (appliedDynamicBands.numBands == 0)
+    {
+        processFilters(channels, numChannels, numSamples);
+        dynamicPosition += numSamples;
+        return;
+    }
+
+    // the gains move once per detector sub-block, which is longer by the oversampling factor here
+    const int subBlockSize = DynamicEq::subBlockSize << currentOversampling;
+
+    SampleType* subBlockChannels[maxNumChannels];
+
+    for (int offset = 0; offset < numSamples;)
+    {
+        // new gains at every sub-block boundary, and whenever a static design has just been applied
+        if (dynamicCoefficientsStale || dynamicPosition % subBlockSize == 0)
+        {
+            applyDynamicGains(dynamicPosition / subBlockSize);
+            dynamicCoefficientsStale = false;
+        }
+
+        const int numSubBlockSamples = juce::jmin(numSamples - offset, subBlockSize - dynamicPosition % subBlockSize);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            subBlockChannels[ch] = channels[ch] + offset;
+
+        processFilters(subBlockChannels, numChannels, numSubBlockSamples);
+
+        offset += numSubBlockSamples;
+        dynamicPosition += numSubBlockSamples;
+    }
+}
+
+void SimpleEQAudioProcessor::applyDynamicGains(int subBlock) noexcept
+{
+    for (int i = 0; i < appliedDynamicBands.numBands; ++i)
+    {
+        const int band = appliedDynamicBands.bands[(size_t)i];
+        const auto& prototype = appliedDynamicBands.prototypes[(size_t)i];
+        const auto channel = appliedDynamicBands.channels[(size_t)i];
+        const double gain = appliedDynamicBands.gainInDecibel[(size_t)i] + dynamicEq.getGainOffset(subBlock, band);
+
+        if (currentEngine == FilterEngine::Svf)
+        {
+            const auto coefficients = SosDesigner::designSvfBell(prototype, gain);
+
+            if (useDoublePrecisionCascades)
+                setBandCoefficients(doubleSvfCascades, band, channel, coefficients);
+            else
+                setBandCoefficients(svfCascades, band, channel, coefficients);
+        }
+        else
+        {
+            const auto coefficients = SosDesigner::designBell(prototype, gain);
+
+            if (useDoublePrecisionCascades)
+                setBandCoefficients(doubleBiquadCascades, band, channel, coefficients);
+            else
+                setBandCoefficients(biquadCascades, band, channel, coefficients);
+        }
+    }
+}
+
+void SimpleEQAudioProcessor::processLinearPhase(juce::dsp::AudioBlock<float> block)
+{
+    // each convolution takes the next channel pair
+    const auto numChannels = block.getNumChannels();
+
+    for (size_t pair = 0; pair < convolutions.size() && pair * 2 < numChannels; ++pair)
+    {
+        auto pairBlock = block.getSubsetChannelBlock(pair * 2, juce::jmin((size_t)2, numChannels - pair * 2));
+        convolutions[pair]->process(juce::dsp::ProcessContextReplacing<float>(pairBlock));
+    }
+}
+
+void SimpleEQAudioProcessor::processLinearPhase(juce::dsp::AudioBlock<double> block)
+{
+    // juce::dsp::Convolution is float only, which is plenty for an FIR
+    const auto numChannels = juce::jmin(block.getNumChannels(), (size_t)floatScratch.getNumChannels());
+    const auto chunkSize = (size_t)floatScratch.getNumSamples();
+
+    if (chunkSize == 0)
+        return;
+
+    for (size_t offset = 0; offset < block.getNumSamples(); offset += chunkSize)
+    {
+        const auto numSamples = juce::jmin(chunkSize, block.getNumSamples() - offset);
+        auto chunk = block.getSubBlock(offset, numSamples).getSubsetChannelBlock(0, numChannels);
+        auto scratch = juce::dsp::AudioBlock<float>(floatScratch).getSubBlock(0, numSamples).getSubsetChannelBlock(0, numChannels);
+
+        scratch.copyFrom(chunk);
+        processLinearPhase(scratch);
+        chunk.copyFrom(scratch);
+    }
+}
+
+template <typename CascadeType, typename SampleType>
+void SimpleEQAudioProcessor::runCascades(std::vector<CascadeType>& cascades, std::vector<LaneGroupCopy<CascadeType, SampleType>>& copies,
+                                         SampleType* const* channels, int numChannels, int numSamples)
+{
+    constexpr int lanes = CascadeType::numLanes;
+    const int numGroups = juce::jmin((int)cascades.size(), (numChannels + lanes - 1) / lanes);
+
+    // what the audio thread no longer does itself with every worker taking its share; the pool's
+    // size is only settled once processInParallel is
+    auto getNumMovedGroups = [this, numGroups]
+    {
+        const int numThreads = numLaneGroupWorkers + 1;
+        return numGroups - (numGroups + numThreads - 1) / numThreads;
+    };
+
+    if (! processInParallel || numGroups < 2 || numSamples > laneGroupCopySamples || (int)copies.size() < numGroups
+        || numSamples * getNumMovedGroups() < minParallelGroupSamples)
+    {
+        processCascades(cascades, channels, numChannels, numSamples);
+        return;
+    }
+
+    // one task per lane group, each cascade keeps its own state and scratch
+    struct Context
+    {
+        CascadeType* cascades;
+        SampleType* const* channels;
+        int numChannels, numSamples;
+    };
+
+    Context context { cascades.data(), channels, numChannels, numSamples };
+
+    laneGroupWorkers->run(laneGroupJob, [](void* contextToUse, void* copiesToUse, int group, LaneGroupWorkers::Stage stage)
+    {
+        auto& copy = static_cast<LaneGroupCopy<CascadeType, SampleType>*>(copiesToUse)[group];
+
+        // on a worker, possibly after the block is over: only the copy is there
+        if (stage == LaneGroupWorkers::Stage::Process)
+        {
+            copy.cascade.process(copy.samples.getArrayOfWritePointers(), copy.numChannels, copy.numSamples);
+            return;
+        }
+
+        auto& task = *static_cast<Context*>(contextToUse);
+        const int firstChannel = group * CascadeType::numLanes;
+        const int numGroupChannels = juce::jmin(CascadeType::numLanes, task.numChannels - firstChannel);
+        auto* const* groupChannels = task.channels + firstChannel;
+
+        if (stage == LaneGroupWorkers::Stage::ToCopy)
+        {
+            copy.cascade = task.cascades[group];
+            copy.numChannels = numGroupChannels;
+            copy.numSamples = task.numSamples;
+
+            for (int ch = 0; ch < numGroupChannels; ++ch)
+                std::copy_n(groupChannels[ch], task.numSamples, copy.samples.getWritePointer(ch));
+        }
+        else if (stage == LaneGroupWorkers::Stage::FromCopy)
+        {
+            task.cascades[group] = copy.cascade;
+
+            for (int ch = 0; ch < numGroupChannels; ++ch)
+                std::copy_n(copy.samples.getReadPointer(ch), task.numSamples, groupChannels[ch]);
+        }
+        else
+        {
+            task.cascades[group].process(groupChannels, numGroupChannels, task.numSamples);
+        }
+    }, &context, copies.data(), numGroups);
+}
+
+void SimpleEQAudioProcessor::processFilters(float* const* channels, int numChannels, int numSamples)
+{
+    if (! useDoublePrecisionCascades)
+    {
+        if (currentEngine == FilterEngine::Svf)
+            runCascades(svfCascades, svfCopies, channels, numChannels, numSamples);
+        else
+            runCascades(biquadCascades, biquadCopies, channels, numChannels, numSamples);
+
+        return;
+    }
+
+    // mixed precision: float in and out, the cascades run on a double copy
+    numChannels = juce::jmin(numChannels, doubleScratch.getNumChannels());
+
+    if (doubleScratch.getNumSamples() == 0)
+        return;
+
+    for (int offset = 0; offset < numSamples; offset += doubleScratch.getNumSamples())
+    {
+        const int numChunkSamples = juce::jmin(doubleScratch.getNumSamples(), numSamples - offset);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            std::copy_n(channels[ch] + offset, numChunkSamples, doubleScratch.getWritePointer(ch));
+
+        processFilters(doubleScratch.getArrayOfWritePointers(), numChannels, numChunkSamples);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            std::transform(doubleScratch.getReadPointer(ch), doubleScratch.getReadPointer(ch) + numChunkSamples,
+                           channels[ch] + offset, [](double sample) { return (float)sample; });
+    }
+}
+
+void SimpleEQAudioProcessor::processFilters(double* const* channels, int numChannels, int numSamples)
+{
+    if (currentEngine == FilterEngine::Svf)
+        runCascades(doubleSvfCascades, doubleSvfCopies, channels, numChannels, numSamples);
+    else
+        runCascades(doubleBiquadCascades, doubleBiquadCopies, channels, numChannels, numSamples);
+}
+
+void SimpleEQAudioProcessor::resetActiveCascades()
+{
+    if (useDoublePrecisionCascades)
+    {
+        if (currentEngine == FilterEngine::Svf)
+            resetCascades(doubleSvfCascades);
+        else
+            resetCascades(doubleBiquadCascades);
+    }
+    else
+    {
+        if (currentEngine == FilterEngine::Svf)
+            resetCascades(svfCascades);
+        else
+            resetCascades(biquadCascades);
+    }
 }
 
 //==============================================================================
 bool SimpleEQAudioProcessor::hasEditor() const
 {
+   #if SIMPLEEQ_HEADLESS
+    return false; // offline tools (e.g. the benchmark) build the processor without the editor
+   #else
     return true; // (change this to false if you choose to not supply an editor)
+   #endif
 }
 
 juce::AudioProcessorEditor* SimpleEQAudioProcessor::createEditor()
 {
+   #if SIMPLEEQ_HEADLESS
+    return nullptr;
+   #else
     return new SimpleEQAudioProcessorEditor (*this);
     //return new juce::GenericAudioProcessorEditor(*this);
+   #endif
 }
 
 //==============================================================================
 void SimpleEQAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
-    juce::MemoryOutputStream mos(destData, true);
-    apvts.state.writeToStream(mos);
-
+    // the parameter values only, in a fixed layout (see BinaryState.h)
+    BinaryState::write(destData, stateParameters);
 }
 
 void SimpleEQAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
 {
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
-    auto valueTree = juce::ValueTree::readFromData(data, sizeInBytes);
-    if (valueTree.isValid()) {
-        apvts.replaceState(valueTree);
-        updateFilters();
+    // may be called on any thread, even during playback. The snapshot keeps the previous filter settings
+    // until the whole state is in; the modes the audio thread reads straight from their parameters
+    // (Filter Engine, Oversampling, Phase Mode, Precision, Smoothing and the like) switch as soon as
+    // they are set, so a block may run the new mode with the old filters. The parameter listeners
+    // only schedule updates.
+    chainSettingsSnapshot.beginUpdate();
+
+    if (! BinaryState::read(data, sizeInBytes, stateParameters))
+    {
+        // sessions saved before the binary format hold the whole ValueTree
+        auto valueTree = juce::ValueTree::readFromData(data, sizeInBytes);
+
+        if (valueTree.isValid())
+            apvts.replaceState(valueTree);
     }
+
+    chainSettingsSnapshot.endUpdate();
+
+    // the coefficient thread may have taken the flags set during the recall and designed from the
+    // held snapshot, so design and load the kernel again from the complete one
+    coefficientsDirty.store(true);
+    kernelDirty.store(true);
 }
 
-ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts)
+void SimpleEQAudioProcessor::parameterChanged(const juce::String& parameterID, float newValue)
 {
-    ChainSettings settings;
+    // may be called on any thread (including the audio thread), so only flag the change
+    chainSettingsSnapshot.markDirty();
+    coefficientsDirty.store(true);
+    kernelDirty.store(true);
+
+    // the audio thread switches modes itself, the host only needs the new latency
+    if (parameterID == "Oversampling" || parameterID == "Phase Mode")
+        latencyDirty.store(true);
+}
+
+int SimpleEQAudioProcessor::useTimeSlice()
+{
+    const int pollIntervalMs = 10;
 
-    settings.lowCutFreq = apvts.getRawParameterValue("LowCut Freq")->load();
-    settings.highCutFreq = apvts.getRawParameterValue("HighCut Freq")->load();
-    settings.peakFreq = apvts.getRawParameterValue("Peak Freq")->load();
-    settings.peakGainInDecibel = apvts.getRawParameterValue("Peak Gain")->load();
-    settings.peakQuality = apvts.getRawParameterValue("Peak Quality")->load();
-    settings.lowCutSlope = static_cast<FilterSlope>( apvts.getRawParameterValue("LowCut Slope")->load() );
-    settings.highCutSlope = static_cast<FilterSlope>( apvts.getRawParameterValue("HighCut Slope")->load() );
+    auto sampleRate = currentSampleRate.load();
 
-    return settings;
+    if (sampleRate <= 0.0)
+        return pollIntervalMs;
+
+    chainSettingsSnapshot.publishIfDirty();
 
+    if (multithreadingParam->load() > 0.5f && ! laneGroupWorkersReady.load())
+        updateLaneGroupWorkers();
+
+    if (latencyDirty.exchange(false))
+        triggerAsyncUpdate();
+
+    if (coefficientsDirty.exchange(false))
+    {
+        auto engine = static_cast<FilterEngine>((int)engineParam->load());
+
+        coefficientBuffer.getWriteBuffer() = makeChainCoefficients(chainSettingsSnapshot.read(), sampleRate, engine);
+        coefficientBuffer.publish();
+    }
+
+    // the kernel is only kept up to date while it is in use, switching to linear phase marks it dirty
+    if (phaseModeParam->load() > 0.5f && kernelDirty.exchange(false))
+        loadLinearPhaseKernel(chainSettingsSnapshot.read());
+
+    return pollIntervalMs;
 }
 
-void SimpleEQAudioProcessor::updateCoefficients(Coefficients& old, const Coefficients& replacements)
+void SimpleEQAudioProcessor::loadLinearPhaseKernel(const ChainSettings& chainSettings)
 {
-    *old = *replacements;
-}
+    const juce::ScopedLock lock(convolutionLock);
+
+    const double sampleRate = hostSampleRate.load();
+
+    if (sampleRate <= 0.0 || convolutions.empty())
+        return;
+
+    // the magnitude response of the biquad design at the host rate, whatever engine is selected.
+    // One kernel for all channels, so the stereo modes fall back to Linked here.
+    auto chainCoefficients = makeChainCoefficients(chainSettings, sampleRate, FilterEngine::Biquad);
+
+    std::array<BiquadCoefficients, BiquadCascade<float>::NumSections> sections;
+    int numSections = 0;
+
+    for (int i = 0; i < chainCoefficients.numLowCutSections; ++i)
+        sections[(size_t)numSections++] = chainCoefficients.lowCut[(size_t)i];
 
+    for (int i = 0; i < chainCoefficients.numActiveBands; ++i)
+        sections[(size_t)numSections++] = chainCoefficients.bands[(size_t)chainCoefficients.activeBands[(size_t)i]];
 
+    for (int i = 0; i < chainCoefficients.numHighCutSections; ++i)
+        sections[(size_t)numSections++] = chainCoefficients.highCut[(size_t)i];
 
+    auto kernel = LinearPhaseKernel::design(sections.data(), numSections, sampleRate);
 
-void SimpleEQAudioProcessor::updatePeakFilter(const ChainSettings& chainSettings)
+    // every convolution gets its own copy, the swap-in is crossfaded by juce::dsp::Convolution
+    for (auto& convolution : convolutions)
+        convolution->loadImpulseResponse(juce::AudioBuffer<float>(kernel), sampleRate,
+                                         juce::dsp::Convolution::Stereo::no,
+                                         juce::dsp::Convolution::Trim::no,
+                                         juce::dsp::Convolution::Normalise::no);
+}
+
+bool SimpleEQAudioProcessor::isLinearPhaseKernelInstalled() const
 {
-    auto peakCoefficients = makePeakFilter(chainSettings, getSampleRate());
+    const int kernelLength = LinearPhaseKernel::getKernelLength(hostSampleRate.load());
 
-    updateCoefficients(leftChain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
-    updateCoefficients(rightChain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
-};
+    return ! convolutions.empty()
+        && std::all_of(convolutions.begin(), convolutions.end(),
+                       [kernelLength](const auto& convolution) { return convolution->getCurrentIRSize() == kernelLength; });
+}
 
+void SimpleEQAudioProcessor::handleAsyncUpdate()
+{
+    updateLatency();
+}
 
+void SimpleEQAudioProcessor::updateLatency()
+{
+    if (phaseModeParam->load() > 0.5f)
+        setLatencySamples(linearPhaseLatency.load());
+    else
+        setLatencySamples(oversamplingLatencies[(size_t)juce::jlimit(0, 2, (int)oversamplingParam->load())]);
+}
 
-void SimpleEQAudioProcessor::updateLowCutFilter(const ChainSettings& chainSettings) 
+void SimpleEQAudioProcessor::applyCoefficients(const ChainCoefficients& chainCoefficients)
 {
-    auto lowCutCoefficients = makeLowCutFilter(chainSettings, getSampleRate());
+    // a set designed for a previous sample rate may still be in flight after prepareToPlay
+    if (chainCoefficients.sampleRate != currentSampleRate.load())
+        return;
 
-    updateCutFilter(leftChain.get<ChainPositions::LowCut>(), lowCutCoefficients, chainSettings.lowCutSlope);
-    updateCutFilter(rightChain.get<ChainPositions::LowCut>(), lowCutCoefficients, chainSettings.lowCutSlope);
-};
+    // the static design resets the dynamic bells to their own gain, the next filter call moves them back
+    appliedDynamicBands = chainCoefficients.dynamicBands;
+    dynamicCoefficientsStale = true;
 
-void SimpleEQAudioProcessor::updateHighCutFilter(const ChainSettings& chainSettings) {
-    auto highCutCoefficients = makeHighCutFilter(chainSettings, getSampleRate());
+    // every section bypassed, the cascades pass the signal through untouched
+    chainIsTransparent = chainCoefficients.numLowCutSections == 0 && chainCoefficients.numActiveBands == 0
+                      && chainCoefficients.numHighCutSections == 0;
 
-    updateCutFilter(leftChain.get <ChainPositions::HighCut>(), highCutCoefficients, chainSettings.highCutSlope);
-    updateCutFilter(rightChain.get<ChainPositions::HighCut>(), highCutCoefficients, chainSettings.highCutSlope);
-};
+    if (chainCoefficients.engine == FilterEngine::Svf)
+    {
+        if (useDoublePrecisionCascades)
+            updateCascades(doubleSvfCascades, chainCoefficients.svfBands, chainCoefficients.svfLowCut, chainCoefficients.svfHighCut, chainCoefficients);
+        else
+            updateCascades(svfCascades, chainCoefficients.svfBands, chainCoefficients.svfLowCut, chainCoefficients.svfHighCut, chainCoefficients);
+    }
+    else
+    {
+        if (useDoublePrecisionCascades)
+            updateCascades(doubleBiquadCascades, chainCoefficients.bands, chainCoefficients.lowCut, chainCoefficients.highCut, chainCoefficients);
+        else
+            updateCascades(biquadCascades, chainCoefficients.bands, chainCoefficients.lowCut, chainCoefficients.highCut, chainCoefficients);
+    }
+}
 
 void SimpleEQAudioProcessor::updateFilters()
 {
-    auto chainSettings = getChainSettings(apvts);
-
-    updatePeakFilter(chainSettings);
-    updateLowCutFilter(chainSettings);
-    updateHighCutFilter(chainSettings);
+    // synchronous version for prepareToPlay, allocates and must not run on the audio thread
+    applyCoefficients(makeChainCoefficients(chainSettingsSnapshot.read(), currentSampleRate.load(), currentEngine));
 };
 
 juce::AudioProcessorValueTreeState::ParameterLayout
@@ -305,20 +1457,69 @@ SimpleEQAudioProcessor::createParameterLayout()
                                                            juce::NormalisableRange<float>(20.f, 20000.f, 1.f, freqSkew),
                                                            20000.f));
 
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak Freq",
-                                                           "Peak Freq",
-                                                           juce::NormalisableRange<float>(20.f, 20000.f, 1.f, freqSkew),
-                                                           750.f));
+    // one set of parameters per band; band 1 (the original peak) starts enabled at 750 Hz,
+    // the others start disabled, spread over the spectrum
+    const juce::StringArray bandTypes { "Bell", "Low Shelf", "High Shelf", "Notch", "Tilt", "High Pass", "Low Pass" };
+
+    for (int band = 0; band < maxBands; ++band)
+    {
+        const auto ids = getBandParameterIDs(band);
+        const float defaultFreq = band == 0 ? 750.f : (float)juce::roundToInt(20.0 * std::pow(1000.0, (band + 0.5) / maxBands));
+
+        layout.add(std::make_unique<juce::AudioParameterBool>(ids.enabled, ids.enabled, band == 0));
+
+        layout.add(std::make_unique<juce::AudioParameterChoice>(ids.type, ids.type, bandTypes, (int)BandType::Bell));
+
+        layout.add(std::make_unique<juce::AudioParameterFloat>(ids.freq,
+                                                               ids.freq,
+                                                               juce::NormalisableRange<float>(20.f, 20000.f, 1.f, freqSkew),
+                                                               defaultFreq));
+
+        layout.add(std::make_unique<juce::AudioParameterFloat>(ids.gain,
+                                                               ids.gain,
+                                                               juce::NormalisableRange<float>(-24.f, 24.f, 0.5f, 1.f),
+                                                               0.f));
+
+        layout.add(std::make_unique<juce::AudioParameterFloat>(ids.quality,
+                                                               ids.quality,
+                                                               juce::NormalisableRange<float>(0.1f, 10.f, 0.05f, 1.f),
+                                                               1.f));
+
+        // placement within the first channel pair, only used in the Left/Right and Mid/Side stereo modes
+        layout.add(std::make_unique<juce::AudioParameterChoice>(ids.channel, ids.channel,
+                                                                juce::StringArray { "Both", "Left / Mid", "Right / Side" }, 0));
+
+        // dynamic EQ, bells only
+        layout.add(std::make_unique<juce::AudioParameterBool>(ids.dynamic, ids.dynamic, false));
+
+        layout.add(std::make_unique<juce::AudioParameterFloat>(ids.threshold,
+                                                               ids.threshold,
+                                                               juce::NormalisableRange<float>(-60.f, 0.f, 0.5f, 1.f),
+                                                               -18.f));
+
+        layout.add(std::make_unique<juce::AudioParameterFloat>(ids.ratio,
+                                                               ids.ratio,
+                                                               juce::NormalisableRange<float>(1.f, 20.f, 0.1f, 0.4f),
+                                                               2.f));
+
+        layout.add(std::make_unique<juce::AudioParameterFloat>(ids.attack,
+                                                               ids.attack,
+                                                               juce::NormalisableRange<float>(0.1f, 200.f, 0.1f, 0.3f),
+                                                               10.f));
+
+        layout.add(std::make_unique<juce::AudioParameterFloat>(ids.release,
+                                                               ids.release,
+                                                               juce::NormalisableRange<float>(5.f, 2000.f, 1.f, 0.3f),
+                                                               100.f));
+    }
 
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak Gain",
-                                                           "Peak Gain",
-                                                           juce::NormalisableRange<float>(-24.f, 24.f, 0.5f, 1.f),
-                                                           0.f));
+    // Left/Right and Mid/Side let every band run on one side of the first channel pair only
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Stereo Mode", "Stereo Mode",
+                                                            juce::StringArray { "Linked", "Left/Right", "Mid/Side" }, 0));
 
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak Quality",
-                                                           "Peak Quality",
-                                                           juce::NormalisableRange<float>(0.1f, 10.f, 0.05f, 1.f),
-                                                           1.f));
+    // what the dynamic bells listen to
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Dynamic Source", "Dynamic Source",
+                                                            juce::StringArray { "Input", "Sidechain" }, 0));
 
     juce::StringArray stringArray;
     int numFilterSlopeOptions = 4;
@@ -334,6 +1535,30 @@ SimpleEQAudioProcessor::createParameterLayout()
     layout.add( std::make_unique<juce::AudioParameterChoice>("LowCut Slope", "LowCut Slope", stringArray, 0) );
     layout.add( std::make_unique<juce::AudioParameterChoice>("HighCut Slope", "HighCut Slope", stringArray, 0) );
 
+    // ramps the filter parameters and redesigns the coefficients every 16/32/64 samples while they move
+    layout.add( std::make_unique<juce::AudioParameterBool>("Smoothing", "Smoothing", false) );
+    layout.add( std::make_unique<juce::AudioParameterChoice>("Smoothing Interval", "Smoothing Interval",
+                                                             juce::StringArray { "16 Samples", "32 Samples", "64 Samples" }, 1) );
+
+    layout.add( std::make_unique<juce::AudioParameterChoice>("Filter Engine", "Filter Engine",
+                                                             juce::StringArray { "Biquad", "SVF" }, 0) );
+
+    // runs the filters at 2x / 4x the host rate, keeps the peak and high cut from cramping near nyquist
+    layout.add( std::make_unique<juce::AudioParameterChoice>("Oversampling", "Oversampling",
+                                                             juce::StringArray { "Off", "2x", "4x" }, 0) );
+
+    // linear phase replaces the IIR cascades with an FIR of the same magnitude response (adds latency)
+    layout.add( std::make_unique<juce::AudioParameterChoice>("Phase Mode", "Phase Mode",
+                                                             juce::StringArray { "Minimum", "Linear" }, 0) );
+
+    // double runs the cascades in double precision with float I/O, double precision hosts always get it
+    layout.add( std::make_unique<juce::AudioParameterChoice>("Precision", "Precision",
+                                                             juce::StringArray { "Float", "Double" }, 0) );
+
+    // buses wider than one SIMD register (e.g. 7.1.4, ambisonics) process their channel groups in parallel
+    layout.add( std::make_unique<juce::AudioParameterChoice>("Multithreading", "Multithreading",
+                                                             juce::StringArray { "Off", "On" }, 0) );
+
     return layout;
 }
 
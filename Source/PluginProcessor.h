@@ -9,15 +9,19 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "SosDesigner.h"
+#include "DynamicEq.h"
+#include "BinaryState.h"
+#include "DspLoadMeter.h"
+#include "LaneGroupWorkers.h"
+#include "SpectrumAnalyzer.h"
+#include "LinearPhaseKernel.h"
+#include "TripleBuffer.h"
 
 //==============================================================================
 /**
 */
 
-using Filter = juce::dsp::IIR::Filter<float>;
-using Coefficients = Filter::CoefficientsPtr;
-using CoefficientsArray = juce::ReferenceCountedArray<juce::dsp::IIR::Coefficients<float>>;
-
 enum FilterSlope
 {
     _12dB,
@@ -26,30 +30,212 @@ enum FilterSlope
     _48dB,
 };
 
+enum FilterEngine
+{
+    Biquad, // transposed direct form II, like juce::dsp::IIR::Filter
+    Svf     // topology-preserving state variable filter
+};
+
+enum BandType
+{
+    Bell,
+    LowShelf,
+    HighShelf,
+    Notch,
+    Tilt,     // shelf around the band frequency, -gain / 2 below and +gain / 2 above
+    HighPass, // resonant 12 dB/Oct
+    LowPass
+};
+
+// how the first channel pair is processed. In LeftRight and MidSide every band can be placed on one
+// side of the pair only, the cuts always run on both.
+enum StereoMode
+{
+    Linked,
+    LeftRight,
+    MidSide  // encoded / decoded on the way into and out of the cascade
+};
+
+enum BandChannel
+{
+    BothChannels,
+    FirstChannel,  // left in LeftRight, mid in MidSide
+    SecondChannel  // right in LeftRight, side in MidSide
+};
+
+// bands between the low and the high cut, one second order section each
+constexpr int maxBands = BiquadCascade<float>::maxBands;
+
+struct BandSettings
+{
+    BandType type { BandType::Bell };
+    float freq { 0 }, gainInDecibel { 0 }, quality { 0 };
+    bool enabled { false };
+    BandChannel channel { BandChannel::BothChannels };
+
+    // bells only: above the threshold the level in the band pulls the gain down by (1 - 1 / ratio) dB per dB
+    bool dynamic { false };
+    float thresholdInDecibel { 0 }, ratio { 1 }, attackMs { 0 }, releaseMs { 0 };
+
+    bool isDynamicBell() const noexcept { return dynamic && type == BandType::Bell; }
+
+    bool operator== (const BandSettings& other) const noexcept
+    {
+        return type == other.type && freq == other.freq && gainInDecibel == other.gainInDecibel
+            && quality == other.quality && enabled == other.enabled && channel == other.channel
+            && dynamic == other.dynamic && thresholdInDecibel == other.thresholdInDecibel
+            && ratio == other.ratio && attackMs == other.attackMs && releaseMs == other.releaseMs;
+    }
+
+    bool operator!= (const BandSettings& other) const noexcept { return ! operator== (other); }
+};
+
 struct ChainSettings // Initialisierung in header???
 {
-    float peakFreq { 0 }, peakGainInDecibel { 0 }, peakQuality { 0 };
+    std::array<BandSettings, maxBands> bands; // band 0 is the original peak
     float lowCutFreq { 0 }, highCutFreq { 0 };
     FilterSlope lowCutSlope { FilterSlope::_12dB }, highCutSlope { FilterSlope::_12dB };
+    StereoMode stereoMode { StereoMode::Linked };
+};
+
+// IDs of the parameters of one band, shared by the parameter layout, the snapshot and the editor.
+// Band 0 keeps the original "Peak ..." IDs so existing sessions and automation still load.
+struct BandParameterIDs
+{
+    juce::String enabled, type, freq, gain, quality, channel;
+    juce::String dynamic, threshold, ratio, attack, release;
+};
+
+BandParameterIDs getBandParameterIDs(int band);
+
+// Lock-free, versioned copy of the parameters behind ChainSettings (seqlock). The parameter handles
+// are resolved once, any thread may publish and readers never block the writer.
+class ChainSettingsSnapshot
+{
+public:
+    explicit ChainSettingsSnapshot(juce::AudioProcessorValueTreeState& apvts);
+
+    // called by the parameter listener, on whatever thread changed the parameter
+    void markDirty() noexcept { dirty.store(true, std::memory_order_release); }
+
+    // holds publishing back while a whole set of parameters changes (state recall), so that no reader
+    // sees half of the filter settings; the complete set is published on the first publishIfDirty after
+    // endUpdate. Parameters outside ChainSettings are not covered.
+    void beginUpdate() noexcept;
+    void endUpdate() noexcept;
+
+    // copies the parameters into the snapshot if they changed since the last publish. Wait-free:
+    // if another thread is publishing right now it returns and the change is picked up next time.
+    void publishIfDirty() noexcept;
+
+    // even while the snapshot is stable, odd while a publish is in progress
+    uint32_t getVersion() const noexcept { return sequence.load(std::memory_order_acquire); }
+
+    // returns false instead of waiting when a publish is in progress (for the audio thread)
+    bool tryRead(ChainSettings& chainSettings, uint32_t& version) const noexcept;
+
+    // retries until it gets a consistent set
+    ChainSettings read() const noexcept;
+
+private:
+    enum Values { LowCutFreq, HighCutFreq, LowCutSlope, HighCutSlope, Stereo, NumGlobalValues };
+    enum BandValues { Enabled, Type, Freq, Gain, Quality, Channel, Dynamic, Threshold, Ratio, Attack, Release, NumBandValues };
+
+    static constexpr int NumValues = NumGlobalValues + maxBands * NumBandValues;
+
+    static constexpr size_t getBandValueIndex(int band, BandValues value) noexcept
+    {
+        return (size_t)(NumGlobalValues + band * NumBandValues + value);
+    }
+
+    std::array<std::atomic<float>*, NumValues> parameters {};
+    std::array<std::atomic<float>, NumValues> values {};
+
+    std::atomic<uint32_t> sequence { 0 };
+    std::atomic<bool> dirty { true };
+    std::atomic<bool> isPublishing { false };
+    std::atomic<bool> isHeld { false };
 };
 
-Coefficients makePeakFilter(const ChainSettings& chainSettings, double sampleRate);
-CoefficientsArray makeLowCutFilter(const ChainSettings& chainSettings, double sampleRate);
-CoefficientsArray makeHighCutFilter(const ChainSettings& chainSettings, double sampleRate);
+// ramps the continuous ChainSettings values towards their targets, slopes switch immediately
+struct SmoothedChainSettings
+{
+    void reset(double sampleRate, double rampLengthInSeconds);
+    void setCurrentAndTargetValue(const ChainSettings& chainSettings);
+
+    // returns true if any target differs from the previous one
+    bool setTargetValue(const ChainSettings& chainSettings);
 
-using CutFilter = juce::dsp::ProcessorChain<Filter, Filter, Filter, Filter>;
-using MonoChain = juce::dsp::ProcessorChain<CutFilter, Filter, CutFilter>;
+    bool isSmoothing() const noexcept;
 
-enum ChainPositions
+    // advances every ramp by numSamples and returns the values reached
+    ChainSettings getNextValues(int numSamples) noexcept;
+
+private:
+    // everything but frequency, quality and gain (type, on/off, dynamics) switches immediately as well
+    struct SmoothedBand
+    {
+        juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> freq, quality;
+        juce::SmoothedValue<float, juce::ValueSmoothingTypes::Linear> gainInDecibel;
+        BandSettings target;
+    };
+
+    std::array<SmoothedBand, maxBands> bands;
+    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> lowCutFreq, highCutFreq;
+    FilterSlope lowCutSlope { FilterSlope::_12dB }, highCutSlope { FilterSlope::_12dB };
+    StereoMode stereoMode { StereoMode::Linked };
+};
+
+// everything the audio thread needs to update the filter cascade without allocating
+struct ChainCoefficients
 {
-    LowCut,
-    Peak,
-    HighCut
+    FilterEngine engine { FilterEngine::Biquad };
+
+    // engine == Biquad, indexed by band, only the active bands are designed
+    std::array<BiquadCoefficients, maxBands> bands;
+    std::array<BiquadCoefficients, SosDesigner::maxCutSections> lowCut, highCut;
+
+    // engine == Svf
+    std::array<SvfCoefficients, maxBands> svfBands;
+    std::array<SvfCoefficients, SosDesigner::maxCutSections> svfLowCut, svfHighCut;
+
+    int numLowCutSections { 0 }, numHighCutSections { 0 }; // 0 when the cut sits at the edge of its range
+    std::array<int, maxBands> activeBands {};              // indices of the active bands, ascending
+    int numActiveBands { 0 };
+    double sampleRate { 0 };
+
+    // where each band runs, always Both in Linked mode. A band is designed once whatever its placement.
+    StereoMode stereoMode { StereoMode::Linked };
+    std::array<BandChannel, maxBands> bandChannels {};
+
+    // active bells in dynamic mode, the audio thread redesigns them from these every sub-block
+    struct DynamicBands
+    {
+        std::array<int, maxBands> bands {};
+        std::array<SosDesigner::BellPrototype, maxBands> prototypes; // indexed like bands
+        std::array<float, maxBands> gainInDecibel {};                // the band's own gain
+        std::array<BandChannel, maxBands> channels {};
+        int numBands { 0 };
     };
 
-ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts);
+    DynamicBands dynamicBands;
+};
+
+ChainCoefficients makeChainCoefficients(const ChainSettings& chainSettings, double sampleRate, FilterEngine engine);
+BiquadCoefficients makeBandCoefficients(const BandSettings& band, double sampleRate);
+SvfCoefficients makeSvfBandCoefficients(const BandSettings& band, double sampleRate);
+
+// cuts at the edge of the 20 Hz - 20 kHz range, disabled bands and static bells, shelves and tilts
+// at 0 dB are left out of the cascade
+int getNumLowCutSections(const ChainSettings& chainSettings);
+int getNumHighCutSections(const ChainSettings& chainSettings);
+bool isBandActive(const BandSettings& band);
 
-class SimpleEQAudioProcessor  : public juce::AudioProcessor
+
+class SimpleEQAudioProcessor  : public juce::AudioProcessor,
+                                public juce::AudioProcessorValueTreeState::Listener,
+                                private juce::TimeSliceClient,
+                                private juce::AsyncUpdater
                             #if JucePlugin_Enable_ARA
                              , public juce::AudioProcessorARAExtension
                             #endif
@@ -63,11 +249,17 @@ public:
     void prepareToPlay (double sampleRate, int samplesPerBlock) override;
     void releaseResources() override;
 
+    // clears every filter, oversampler, convolution and detector state, keeping the current design
+    void reset() override;
+
    #ifndef JucePlugin_PreferredChannelConfigurations
     bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+
+    bool supportsDoublePrecisionProcessing() const override { return true; }
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -92,62 +284,331 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
 
-    MonoChain leftChain, rightChain;
+    //==============================================================================
+    void parameterChanged (const juce::String& parameterID, float newValue) override;
 
     static juce::AudioProcessorValueTreeState::ParameterLayout
         createParameterLayout();
 
     juce::AudioProcessorValueTreeState apvts { *this, nullptr, "Parameters", createParameterLayout() }; // why initialized in header? this way it possibly gets copied and duplicated which causes a linking error
 
+    // what the DSP and the editor read instead of looking the parameters up by name
+    ChainSettingsSnapshot& getChainSettingsSnapshot() noexcept { return chainSettingsSnapshot; }
+
+    // signal before and after the EQ for the editor's spectrum analyser, only fed while enabled
+    AnalyzerFifo& getPreEqFifo() noexcept { return preEqFifo; }
+    AnalyzerFifo& getPostEqFifo() noexcept { return postEqFifo; }
+
+    // true once every convolution runs a kernel of the length the current sample rate needs. The kernel
+    // loads in the background and processBlock swaps it in, so call this between processBlock calls.
+    bool isLinearPhaseKernelInstalled() const;
+    void setAnalyzerEnabled(bool shouldBeEnabled) noexcept { analyzerEnabled.store(shouldBeEnabled); }
+
+    // the rate the filters are designed for, the host rate times the oversampling factor
+    double getProcessingSampleRate() const noexcept { return currentSampleRate.load(); }
+
+    // what the last block did: the DSP is skipped entirely while idling on silence or transparent settings
+    enum ProcessingState
+    {
+        Processing,
+        SilentInput,        // silent input and every filter tail decayed
+        TransparentSettings // no active section, the signal passes through untouched
+    };
+
+    ProcessingState getProcessingState() const noexcept { return static_cast<ProcessingState>(processingState.load(std::memory_order_relaxed)); }
+
+    // -160 dB, well above the denormal range and below any converter's noise floor
+    static constexpr double silenceThreshold = 1.0e-8;
+
+    // cost of processBlock against the real-time budget over the last DspLoadMeter::windowSeconds,
+    // readable from any thread. No plugin format carries this to the host, wrappers and tools read it here.
+    DspLoadSnapshot getDspLoad() const noexcept { return dspLoadMeter.getSnapshot(); }
+    uint32_t getDspLoadVersion() const noexcept { return dspLoadMeter.getVersion(); }
+    void resetDspLoadWorstCase() noexcept { dspLoadMeter.resetWorstCase(); }
+
 private:
 
-    static void updateCoefficients(Coefficients& old, const Coefficients& replacements);
+    ChainSettingsSnapshot chainSettingsSnapshot { apvts };
 
-    // why has index to be part of the template?
-    template <int index, typename ChainElementType, typename CoefficientsType>
-    void updateCutFilterElement(ChainElementType& cutFilter, const CoefficientsType& cutCoefficients)
+    AnalyzerFifo preEqFifo, postEqFifo;
+    std::atomic<bool> analyzerEnabled { false };
+
+    // latest snapshot seen by the audio thread, only touched there
+    ChainSettings audioThreadSettings;
+    uint32_t audioThreadSettingsVersion = 1; // odd, so the first stable version counts as new
+
+    // returns true if the snapshot moved on since the last call
+    bool updateAudioThreadSettings() noexcept;
+
+    // one background thread shared by all instances, redesigns coefficients when parameters changed
+    struct CoefficientThread : juce::TimeSliceThread
     {
-        updateCoefficients(cutFilter.get<index>().coefficients, cutCoefficients[index]);
-        cutFilter.setBypassed<index>(false);
-    }
+        CoefficientThread() : juce::TimeSliceThread("SimpleEQ Coefficients") { startThread(); }
+        ~CoefficientThread() override { stopThread(1000); }
+    };
+
+    juce::SharedResourcePointer<CoefficientThread> coefficientThread;
+    TripleBuffer<ChainCoefficients> coefficientBuffer;
+    std::atomic<bool> coefficientsDirty { true };
+    std::atomic<double> currentSampleRate { 0.0 };
 
-    template <typename ChainElementType, typename CoefficientType>
-    void updateCutFilter(ChainElementType& cutFilter,
-                          const CoefficientType& cutCoefficients,
-                          const FilterSlope& filterSlope)
+    int useTimeSlice() override;
+
+public:
+    // up to third order ambisonics (16 channels), 7.1.4 needs 12
+    static constexpr int maxNumChannels = 16;
+
+private:
+    // low cut, bands and high cut, one cascade per group of channels with one channel per SIMD lane,
+    // sized from the bus layout in prepareToPlay
+    static constexpr int numLanes = BiquadCascade<float>::numLanes;
+    static constexpr int numDoubleLanes = BiquadCascade<double>::numLanes;
+
+    std::vector<BiquadCascade<float>> biquadCascades;
+    std::vector<SvfCascade<float>> svfCascades;
+
+    // double precision cascades, for double precision hosts and the "Double" (mixed) precision mode
+    std::vector<BiquadCascade<double>> doubleBiquadCascades;
+    std::vector<SvfCascade<double>> doubleSvfCascades;
+    juce::AudioBuffer<double> doubleScratch;
+    juce::AudioBuffer<float> floatScratch;
+    std::atomic<float>* precisionParam = nullptr;
+    bool useDoublePrecisionCascades = false;
+
+    std::atomic<float>* engineParam = nullptr;
+    FilterEngine currentEngine { FilterEngine::Biquad };
+
+    template <typename CascadeType, typename CoefficientsType>
+    static void updateCutFilter(CascadeType& cascade,
+                                int firstSection,
+                                const std::array<CoefficientsType, SosDesigner::maxCutSections>& cutCoefficients,
+                                int numSections)
     {
-        cutFilter.setBypassed<0>(true);
-        cutFilter.setBypassed<1>(true);
-        cutFilter.setBypassed<2>(true);
-        cutFilter.setBypassed<3>(true);
+        for (int i = 0; i < numSections; ++i)
+            cascade.setCoefficients(firstSection + i, cutCoefficients[i]);
+    }
 
-        switch ( filterSlope )
-        {
+    // a band placed on one side of the pair only touches that lane of the first lane group, every other
+    // lane gets a pass-through section
+    template <typename CascadeType, typename CoefficientsType>
+    static void setBandLanes(CascadeType& cascade, bool isFirstGroup, int band, BandChannel channel,
+                             const CoefficientsType& coefficients)
+    {
+        const int section = CascadeType::FirstBand + band;
 
-        case _48dB:
-        {
-            updateCutFilterElement<3>(cutFilter, cutCoefficients);
-        }
-        case _36dB:
+        if (channel == BandChannel::BothChannels)
         {
-            updateCutFilterElement<2>(cutFilter, cutCoefficients);
+            cascade.setCoefficients(section, coefficients);
+            return;
         }
-        case _24dB:
+
+        cascade.setCoefficients(section, CoefficientsType());
+
+        const int lane = channel == BandChannel::FirstChannel ? 0 : 1;
+
+        if (isFirstGroup && lane < CascadeType::numLanes)
+            cascade.setCoefficients(section, lane, coefficients);
+    }
+
+    template <typename CascadeType, typename CoefficientsType>
+    static void updateCascades(std::vector<CascadeType>& cascades,
+                              const std::array<CoefficientsType, maxBands>& bandCoefficients,
+                              const std::array<CoefficientsType, SosDesigner::maxCutSections>& lowCutCoefficients,
+                              const std::array<CoefficientsType, SosDesigner::maxCutSections>& highCutCoefficients,
+                              const ChainCoefficients& chainCoefficients)
+    {
+        for (auto& cascade : cascades)
         {
-            updateCutFilterElement<1>(cutFilter, cutCoefficients);
+            const bool isFirstGroup = &cascade == &cascades.front();
+
+            for (int i = 0; i < chainCoefficients.numActiveBands; ++i)
+            {
+                const int band = chainCoefficients.activeBands[(size_t)i];
+                setBandLanes(cascade, isFirstGroup, band, chainCoefficients.bandChannels[(size_t)band], bandCoefficients[(size_t)band]);
+            }
+
+            cascade.setMidSide(isFirstGroup && chainCoefficients.stereoMode == StereoMode::MidSide);
+
+            updateCutFilter(cascade, CascadeType::FirstLowCut, lowCutCoefficients, chainCoefficients.numLowCutSections);
+            updateCutFilter(cascade, CascadeType::FirstHighCut, highCutCoefficients, chainCoefficients.numHighCutSections);
+
+            cascade.setActiveSections(chainCoefficients.numLowCutSections,
+                                      chainCoefficients.activeBands.data(),
+                                      chainCoefficients.numActiveBands,
+                                      chainCoefficients.numHighCutSections);
         }
-        case _12dB:
+    }
+
+    template <typename CascadeType, typename SampleType>
+    static void processCascades(std::vector<CascadeType>& cascades, SampleType* const* channels, int numChannels, int numSamples)
+    {
+        constexpr int lanes = CascadeType::numLanes;
+
+        // each cascade takes the next lanes channels
+        for (int group = 0; group < (int)cascades.size() && group * lanes < numChannels; ++group)
         {
-            updateCutFilterElement<0>(cutFilter, cutCoefficients);
-        }
+            const int firstChannel = group * lanes;
+            cascades[(size_t)group].process(channels + firstChannel, juce::jmin(lanes, numChannels - firstChannel), numSamples);
         }
     }
 
-    void updatePeakFilter(const ChainSettings& chainSettings);
+    template <typename CascadeType, typename CoefficientsType>
+    static void setBandCoefficients(std::vector<CascadeType>& cascades, int band, BandChannel channel, const CoefficientsType& coefficients)
+    {
+        for (auto& cascade : cascades)
+            setBandLanes(cascade, &cascade == &cascades.front(), band, channel, coefficients);
+    }
+
+    template <typename CascadeType>
+    static void resetCascades(std::vector<CascadeType>& cascades)
+    {
+        for (auto& cascade : cascades)
+            cascade.reset();
+    }
+
+    template <typename SampleType>
+    void processBlockInternal(juce::AudioBuffer<SampleType>& buffer);
+
+    void processFilters(float* const* channels, int numChannels, int numSamples);
+    void processFilters(double* const* channels, int numChannels, int numSamples);
+    void resetActiveCascades();
+
+    // "Multithreading": the lane groups of a wide bus run on worker threads as well. The groups the workers
+    // take off the audio thread have to win back waking them (~20 us) plus the copies (~1 ns per sample
+    // and group), against ~20 ns per sample and group of a chain of about five sections. So a call only
+    // goes parallel from numSamples * moved groups >= minParallelGroupSamples; shorter ones (small host
+    // blocks, ramps, the dynamic sub-blocks) stay on the audio thread. The benchmark's --parallel runs
+    // check it on the target machine.
+    static constexpr int minParallelGroupSamples = 1024;
+
+    // one pool for every instance in the process, each attaches its own job
+    juce::SharedResourcePointer<LaneGroupWorkers> laneGroupWorkers;
+    LaneGroupWorkers::Job laneGroupJob;
+    juce::CriticalSection laneGroupWorkersLock; // prepareToPlay vs. the coefficient thread, never the audio thread
+    std::atomic<bool> laneGroupWorkersReady { false };
+    std::atomic<float>* multithreadingParam = nullptr;
+    int numLaneGroups = 0;      // for the current layout, 0 while not prepared
+    int maxCascadeSamples = 0;  // the longest call the cascades get, with oversampling
+    int numLaneGroupWorkers = 0; // in the pool, set before laneGroupWorkersReady
+    bool processInParallel = false;
+
+    // what a worker processes instead of the cascade and the buffers, so the audio thread never waits
+    // for it longer than it takes to do the group itself. Allocated when the workers are first used.
+    template <typename CascadeType, typename SampleType>
+    struct LaneGroupCopy
+    {
+        CascadeType cascade;
+        juce::AudioBuffer<SampleType> samples;
+        int numChannels = 0, numSamples = 0;
+    };
+
+    std::vector<LaneGroupCopy<BiquadCascade<float>, float>> biquadCopies;
+    std::vector<LaneGroupCopy<SvfCascade<float>, float>> svfCopies;
+    std::vector<LaneGroupCopy<BiquadCascade<double>, double>> doubleBiquadCopies;
+    std::vector<LaneGroupCopy<SvfCascade<double>, double>> doubleSvfCopies;
+    int laneGroupCopySamples = 0; // what the copies hold, 0 until they are allocated
 
-    void updateLowCutFilter(const ChainSettings& chainSettings);
+    template <typename CascadeType, typename SampleType>
+    static void allocateLaneGroupCopies(std::vector<LaneGroupCopy<CascadeType, SampleType>>& copies, size_t numGroups, int numSamples)
+    {
+        copies.resize(numGroups);
+
+        for (auto& copy : copies)
+            copy.samples.setSize(CascadeType::numLanes, numSamples);
+    }
+
+    // attaches to the workers if the parameter asks for them, not on the audio thread
+    void updateLaneGroupWorkers();
+    void detachLaneGroupWorkers();
+
+    template <typename CascadeType, typename SampleType>
+    void runCascades(std::vector<CascadeType>& cascades, std::vector<LaneGroupCopy<CascadeType, SampleType>>& copies,
+                     SampleType* const* channels, int numChannels, int numSamples);
+
+    // parameter smoothing: coefficients are redesigned on the audio thread every few samples while ramping
+    SmoothedChainSettings smoothedSettings;
+    static constexpr double smoothingRampSeconds = 0.05;
+    std::atomic<float>* smoothingParam = nullptr;
+    std::atomic<float>* smoothingIntervalParam = nullptr;
+    bool wasSmoothing = false;
+
+    template <typename SampleType>
+    void processSmoothed(SampleType* const* channels, int numChannels, int numSamples, bool settingsChanged, bool forceDesign);
+
+    // 2x and 4x oversampling around the cascades, both allocated in prepareToPlay (in the host's
+    // precision) so that switching on the audio thread only resets the state of the newly selected one
+    std::array<std::unique_ptr<juce::dsp::Oversampling<float>>, 2> oversamplers;
+    std::array<std::unique_ptr<juce::dsp::Oversampling<double>>, 2> doubleOversamplers;
+    std::array<int, 3> oversamplingLatencies {};
+    std::atomic<float>* oversamplingParam = nullptr;
+    int currentOversampling = 0;
+    std::atomic<double> hostSampleRate { 0.0 };
+
+    template <typename SampleType>
+    juce::dsp::Oversampling<SampleType>* getOversampler() const noexcept
+    {
+        if (currentOversampling == 0)
+            return nullptr;
+
+        if constexpr (std::is_same<SampleType, double>::value)
+            return doubleOversamplers[(size_t)currentOversampling - 1].get();
+        else
+            return oversamplers[(size_t)currentOversampling - 1].get();
+    }
 
-    void updateHighCutFilter(const ChainSettings& chainSettings);
+    // linear phase mode: the cascades' magnitude response as an FIR kernel, one non-uniformly
+    // partitioned convolution per channel pair. Kernels are designed on the coefficient thread and
+    // crossfaded in by juce::dsp::Convolution; oversampling and the stereo modes are bypassed in this mode.
+    juce::dsp::ConvolutionMessageQueue convolutionQueue;
+    std::vector<std::unique_ptr<juce::dsp::Convolution>> convolutions;
+    juce::CriticalSection convolutionLock; // prepareToPlay vs. the coefficient thread, never the audio thread
+    std::atomic<float>* phaseModeParam = nullptr;
+    std::atomic<bool> kernelDirty { true };
+    std::atomic<int> linearPhaseLatency { 0 };
+    bool isLinearPhase = false;
+
+    // dynamic bells: the detectors run over the host block (input or sidechain bus) before the cascades,
+    // which then redesign the dynamic bells every DynamicEq::subBlockSize host samples. Not applied in
+    // linear phase mode, where the bells keep their own gain.
+    DynamicEq dynamicEq;
+    std::atomic<float>* dynamicSourceParam = nullptr;
+    ChainCoefficients::DynamicBands appliedDynamicBands; // from the design the cascades currently run
+    bool dynamicCoefficientsStale = false;
+    int dynamicPosition = 0; // processing samples since the start of the block
+
+    void updateDynamicEq(const ChainSettings& chainSettings) noexcept;
+
+    template <typename SampleType>
+    void processFiltersWithDynamics(SampleType* const* channels, int numChannels, int numSamples);
+
+    void applyDynamicGains(int subBlock) noexcept;
+
+    void loadLinearPhaseKernel(const ChainSettings& chainSettings);
+    void processLinearPhase(juce::dsp::AudioBlock<float> block);
+    void processLinearPhase(juce::dsp::AudioBlock<double> block);
+    void updateLatency();
+
+    // a mode change reports the new latency from the message thread, setLatencySamples notifies the host
+    // synchronously: the listener sets the flag, the coefficient thread triggers the update
+    std::atomic<bool> latencyDirty { false };
+    void handleAsyncUpdate() override;
+
+    // auto-bypass: silentInputSamples counts the host samples since the input last exceeded
+    // silenceThreshold, chainIsTransparent is set from the design the cascades currently run
+    std::atomic<int> processingState { Processing };
+    juce::int64 silentInputSamples = 0;
+    bool isIdleOnSilence = false;
+    bool chainIsTransparent = false;
+
+    template <typename SampleType>
+    void updateIdleOnSilence(const juce::AudioBuffer<SampleType>& buffer, int numChannels) noexcept;
+
+    DspLoadMeter dspLoadMeter;
+
+    // every parameter in the order of the binary state, see getStateParameterIDs()
+    BinaryState::Parameters stateParameters;
+
+    void applyCoefficients(const ChainCoefficients& chainCoefficients);
 
     void updateFilters();
 
@@ -0,0 +1,344 @@
+/*
+  ==============================================================================
+
+    RealtimeChecks.cpp
+
+    The hooks behind RealtimeChecks.h. operator new / delete are replaced on
+    every platform; on Linux with glibc malloc and friends are interposed as
+    well (forwarding to glibc's __libc_* entry points) and
+    pthread_mutex_lock is looked up with dlsym(RTLD_NEXT). Interposing only
+    works for the executable the hooks are linked into (the benchmark, a
+    test runner), not for a plugin loaded by a host.
+
+  ==============================================================================
+*/
+
+#include "RealtimeChecks.h"
+
+#if SIMPLEEQ_RT_CHECKS
+
+#include <new>
+
+#if JUCE_MSVC
+ #include <intrin.h>
+ #define SIMPLEEQ_CALL_SITE _ReturnAddress()
+#else
+ #define SIMPLEEQ_CALL_SITE __builtin_return_address(0)
+#endif
+
+#if JUCE_LINUX && defined (__GLIBC__)
+ #define SIMPLEEQ_RT_CHECKS_INTERPOSE 1
+ #include <dlfcn.h>
+ #include <pthread.h>
+
+extern "C"
+{
+    void* __libc_malloc (size_t);
+    void* __libc_calloc (size_t, size_t);
+    void* __libc_realloc (void*, size_t);
+    void __libc_free (void*);
+}
+#else
+ #define SIMPLEEQ_RT_CHECKS_INTERPOSE 0
+#endif
+
+#if JUCE_LINUX || JUCE_MAC
+ #include <dlfcn.h>
+#endif
+
+namespace
+{
+    // all constant initialised, the hooks may run before any static constructor
+    thread_local bool isInAudioCallback = false;
+    thread_local bool isInHook = false;
+    thread_local RealtimeChecks::Report currentReport, lastReport;
+
+    std::atomic<juce::int64> totalBlocks { 0 }, totalViolatingBlocks { 0 };
+    std::atomic<juce::int64> totalAllocations { 0 }, totalDeallocations { 0 }, totalLocks { 0 };
+
+    // only the outermost hook records, so operator new -> malloc counts once
+    struct HookScope
+    {
+        HookScope() noexcept : wasInHook(isInHook) { isInHook = true; }
+        ~HookScope() noexcept { isInHook = wasInHook; }
+
+        bool isOutermost() const noexcept { return ! wasInHook; }
+
+        const bool wasInHook;
+    };
+
+    void* allocate(size_t size, void* callSite) noexcept
+    {
+        HookScope scope;
+
+        if (scope.isOutermost())
+            RealtimeChecks::record(RealtimeChecks::Allocation, size, callSite);
+
+        return std::malloc(size == 0 ? 1 : size);
+    }
+
+    void deallocate(void* ptr, void* callSite) noexcept
+    {
+        if (ptr == nullptr)
+            return;
+
+        HookScope scope;
+
+        if (scope.isOutermost())
+            RealtimeChecks::record(RealtimeChecks::Deallocation, 0, callSite);
+
+        std::free(ptr);
+    }
+
+    void* allocateAligned(size_t size, std::align_val_t alignment, void* callSite) noexcept
+    {
+        HookScope scope;
+
+        if (scope.isOutermost())
+            RealtimeChecks::record(RealtimeChecks::Allocation, size, callSite);
+
+        const auto align = juce::jmax((size_t)alignment, sizeof(void*));
+
+       #if JUCE_MSVC
+        return _aligned_malloc(size == 0 ? 1 : size, align);
+       #else
+        void* ptr = nullptr;
+        return posix_memalign(&ptr, align, size == 0 ? 1 : size) == 0 ? ptr : nullptr;
+       #endif
+    }
+
+    void deallocateAligned(void* ptr, void* callSite) noexcept
+    {
+        if (ptr == nullptr)
+            return;
+
+        HookScope scope;
+
+        if (scope.isOutermost())
+            RealtimeChecks::record(RealtimeChecks::Deallocation, 0, callSite);
+
+       #if JUCE_MSVC
+        _aligned_free(ptr);
+       #else
+        std::free(ptr);
+       #endif
+    }
+
+    const char* getEventName(RealtimeChecks::EventType type) noexcept
+    {
+        switch (type)
+        {
+            case RealtimeChecks::Allocation:   return "allocation";
+            case RealtimeChecks::Deallocation: return "deallocation";
+            case RealtimeChecks::Lock:         return "mutex lock";
+        }
+
+        return "";
+    }
+}
+
+//==============================================================================
+void RealtimeChecks::begin() noexcept
+{
+    currentReport = Report();
+    isInAudioCallback = true;
+}
+
+void RealtimeChecks::end() noexcept
+{
+    isInAudioCallback = false;
+    lastReport = currentReport;
+
+    totalBlocks.fetch_add(1, std::memory_order_relaxed);
+
+    if (! currentReport.isClean())
+    {
+        totalViolatingBlocks.fetch_add(1, std::memory_order_relaxed);
+        totalAllocations.fetch_add(currentReport.numAllocations, std::memory_order_relaxed);
+        totalDeallocations.fetch_add(currentReport.numDeallocations, std::memory_order_relaxed);
+        totalLocks.fetch_add(currentReport.numLocks, std::memory_order_relaxed);
+    }
+}
+
+void RealtimeChecks::record(EventType type, size_t size, void* callSite) noexcept
+{
+    if (! isInAudioCallback)
+        return;
+
+    auto& report = currentReport;
+
+    switch (type)
+    {
+        case Allocation:   ++report.numAllocations; report.bytesAllocated += size; break;
+        case Deallocation: ++report.numDeallocations; break;
+        case Lock:         ++report.numLocks; break;
+    }
+
+    if (report.numEvents < Report::maxEvents)
+        report.events[(size_t)report.numEvents++] = { type, size, callSite };
+}
+
+const RealtimeChecks::Report& RealtimeChecks::getLastReport() noexcept
+{
+    return lastReport;
+}
+
+RealtimeChecks::Totals RealtimeChecks::getTotals() noexcept
+{
+    Totals totals;
+    totals.numBlocks = totalBlocks.load();
+    totals.numViolatingBlocks = totalViolatingBlocks.load();
+    totals.numAllocations = totalAllocations.load();
+    totals.numDeallocations = totalDeallocations.load();
+    totals.numLocks = totalLocks.load();
+    return totals;
+}
+
+juce::String RealtimeChecks::describe(const Report& report)
+{
+    juce::String text;
+    text << report.numAllocations << " allocations (" << (juce::int64)report.bytesAllocated << " bytes), "
+         << report.numDeallocations << " deallocations, " << report.numLocks << " mutex locks";
+
+    for (int i = 0; i < report.numEvents; ++i)
+    {
+        const auto& event = report.events[(size_t)i];
+
+        text << juce::newLine << "  " << getEventName(event.type);
+
+        if (event.type == Allocation)
+            text << " of " << (juce::int64)event.size << " bytes";
+
+        text << " at " << juce::String::toHexString((juce::pointer_sized_int)event.callSite);
+
+       #if JUCE_LINUX || JUCE_MAC
+        Dl_info info;
+
+        if (dladdr(event.callSite, &info) != 0 && info.dli_sname != nullptr)
+            text << " (" << info.dli_sname << " + "
+                 << (int)(static_cast<const char*>(event.callSite) - static_cast<const char*>(info.dli_saddr)) << ")";
+       #endif
+    }
+
+    if (report.numAllocations + report.numDeallocations + report.numLocks > report.numEvents)
+        text << juce::newLine << "  ...";
+
+    return text;
+}
+
+//==============================================================================
+void* operator new (std::size_t size)
+{
+    if (auto* ptr = allocate(size, SIMPLEEQ_CALL_SITE))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[] (std::size_t size)
+{
+    if (auto* ptr = allocate(size, SIMPLEEQ_CALL_SITE))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void* operator new (std::size_t size, const std::nothrow_t&) noexcept   { return allocate(size, SIMPLEEQ_CALL_SITE); }
+void* operator new[] (std::size_t size, const std::nothrow_t&) noexcept { return allocate(size, SIMPLEEQ_CALL_SITE); }
+
+void operator delete (void* ptr) noexcept                               { deallocate(ptr, SIMPLEEQ_CALL_SITE); }
+void operator delete[] (void* ptr) noexcept                             { deallocate(ptr, SIMPLEEQ_CALL_SITE); }
+void operator delete (void* ptr, std::size_t) noexcept                  { deallocate(ptr, SIMPLEEQ_CALL_SITE); }
+void operator delete[] (void* ptr, std::size_t) noexcept                { deallocate(ptr, SIMPLEEQ_CALL_SITE); }
+void operator delete (void* ptr, const std::nothrow_t&) noexcept        { deallocate(ptr, SIMPLEEQ_CALL_SITE); }
+void operator delete[] (void* ptr, const std::nothrow_t&) noexcept      { deallocate(ptr, SIMPLEEQ_CALL_SITE); }
+
+void* operator new (std::size_t size, std::align_val_t alignment)
+{
+    if (auto* ptr = allocateAligned(size, alignment, SIMPLEEQ_CALL_SITE))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[] (std::size_t size, std::align_val_t alignment)
+{
+    if (auto* ptr = allocateAligned(size, alignment, SIMPLEEQ_CALL_SITE))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void operator delete (void* ptr, std::align_val_t) noexcept                 { deallocateAligned(ptr, SIMPLEEQ_CALL_SITE); }
+void operator delete[] (void* ptr, std::align_val_t) noexcept               { deallocateAligned(ptr, SIMPLEEQ_CALL_SITE); }
+void operator delete (void* ptr, std::size_t, std::align_val_t) noexcept    { deallocateAligned(ptr, SIMPLEEQ_CALL_SITE); }
+void operator delete[] (void* ptr, std::size_t, std::align_val_t) noexcept  { deallocateAligned(ptr, SIMPLEEQ_CALL_SITE); }
+
+//==============================================================================
+#if SIMPLEEQ_RT_CHECKS_INTERPOSE
+extern "C"
+{
+    void* malloc (size_t size) noexcept
+    {
+        HookScope scope;
+
+        if (scope.isOutermost())
+            RealtimeChecks::record(RealtimeChecks::Allocation, size, SIMPLEEQ_CALL_SITE);
+
+        return __libc_malloc(size);
+    }
+
+    void* calloc (size_t numElements, size_t elementSize) noexcept
+    {
+        HookScope scope;
+
+        if (scope.isOutermost())
+            RealtimeChecks::record(RealtimeChecks::Allocation, numElements * elementSize, SIMPLEEQ_CALL_SITE);
+
+        return __libc_calloc(numElements, elementSize);
+    }
+
+    void* realloc (void* ptr, size_t size) noexcept
+    {
+        HookScope scope;
+
+        if (scope.isOutermost())
+            RealtimeChecks::record(RealtimeChecks::Allocation, size, SIMPLEEQ_CALL_SITE);
+
+        return __libc_realloc(ptr, size);
+    }
+
+    void free (void* ptr) noexcept
+    {
+        if (ptr != nullptr)
+        {
+            HookScope scope;
+
+            if (scope.isOutermost())
+                RealtimeChecks::record(RealtimeChecks::Deallocation, 0, SIMPLEEQ_CALL_SITE);
+        }
+
+        __libc_free(ptr);
+    }
+
+    int pthread_mutex_lock (pthread_mutex_t* mutex) noexcept
+    {
+        using LockFunction = int (*) (pthread_mutex_t*);
+        static std::atomic<LockFunction> realLock { nullptr };
+
+        auto lock = realLock.load(std::memory_order_acquire);
+
+        if (lock == nullptr)
+        {
+            lock = reinterpret_cast<LockFunction>(dlsym(RTLD_NEXT, "pthread_mutex_lock"));
+            realLock.store(lock, std::memory_order_release);
+        }
+
+        RealtimeChecks::record(RealtimeChecks::Lock, 0, SIMPLEEQ_CALL_SITE);
+
+        return lock(mutex);
+    }
+}
+#endif
+
+#endif
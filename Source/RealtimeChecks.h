@@ -0,0 +1,94 @@
+/*
+  ==============================================================================
+
+    RealtimeChecks.h
+
+    Debug / CI instrumentation for the audio thread, compiled in with
+    SIMPLEEQ_RT_CHECKS=1. While a thread is inside a ScopedAudioCallback
+    the global operator new / delete and (on Linux) malloc, calloc, realloc,
+    free and pthread_mutex_lock record every call: counts, bytes and the
+    call site of the first few, per block. The hooks live in
+    RealtimeChecks.cpp; without the flag everything here compiles to
+    nothing.
+
+    The report of the last block stays with the thread that ran it, so a
+    benchmark or test calling processBlock can read it right afterwards and
+    assert that it's empty. Totals over all blocks and threads are kept as
+    well.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#ifndef SIMPLEEQ_RT_CHECKS
+ #define SIMPLEEQ_RT_CHECKS 0
+#endif
+
+struct RealtimeChecks
+{
+    enum EventType { Allocation, Deallocation, Lock };
+
+    struct Event
+    {
+        EventType type;
+        size_t size;    // bytes, allocations only
+        void* callSite; // return address of the hooked call
+    };
+
+    // one block on one thread, fixed size so recording never allocates
+    struct Report
+    {
+        static constexpr int maxEvents = 16;
+
+        int numAllocations = 0, numDeallocations = 0, numLocks = 0;
+        size_t bytesAllocated = 0;
+
+        std::array<Event, maxEvents> events {}; // the first maxEvents of the block
+        int numEvents = 0;
+
+        bool isClean() const noexcept { return numAllocations == 0 && numDeallocations == 0 && numLocks == 0; }
+    };
+
+    // counts over every checked block since startup
+    struct Totals
+    {
+        juce::int64 numBlocks = 0, numViolatingBlocks = 0;
+        juce::int64 numAllocations = 0, numDeallocations = 0, numLocks = 0;
+    };
+
+    // marks the calling thread as the audio thread for its lifetime, wrap processBlock in it
+    struct ScopedAudioCallback
+    {
+        ScopedAudioCallback() noexcept   { begin(); }
+        ~ScopedAudioCallback() noexcept  { end(); }
+    };
+
+    static constexpr bool isEnabled() noexcept { return SIMPLEEQ_RT_CHECKS != 0; }
+
+   #if SIMPLEEQ_RT_CHECKS
+    static void begin() noexcept;
+    static void end() noexcept;
+
+    // called by the hooks, only records while the calling thread is inside a ScopedAudioCallback
+    static void record(EventType type, size_t size, void* callSite) noexcept;
+
+    // the last block this thread ran inside a ScopedAudioCallback
+    static const Report& getLastReport() noexcept;
+    static Totals getTotals() noexcept;
+
+    // human readable report with the call sites resolved to symbols where possible, allocates
+    static juce::String describe(const Report& report);
+   #else
+    static void begin() noexcept {}
+    static void end() noexcept {}
+    static void record(EventType, size_t, void*) noexcept {}
+
+    static const Report& getLastReport() noexcept { static const Report empty; return empty; }
+    static Totals getTotals() noexcept { return {}; }
+
+    static juce::String describe(const Report&) { return {}; }
+   #endif
+};
@@ -0,0 +1,296 @@
+/*
+  ==============================================================================
+
+    SosDesigner.h
+
+    Closed-form designers for the band and cut sections, written straight
+    into the plain coefficient structs of BiquadCascade and SvfCascade. The
+    Butterworth damping of every section is tabulated per order at compile
+    time, so a cut costs one tan() and a few multiplies per section at
+    update time and nothing allocates, unlike
+    juce::dsp::FilterDesign::designIIR*HighOrderButterworthMethod which
+    recomputes the poles and returns a fresh array of ref-counted sections.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "BiquadCascade.h"
+#include "SvfCascade.h"
+
+// 1 / Q of every second order section of an even order Butterworth filter, built at compile time
+struct ButterworthTable
+{
+    static constexpr int maxSections = 4; // order 8, 48 dB/oct
+
+    using DampingTable = std::array<std::array<double, maxSections>, maxSections>;
+
+    // section k of order 2n: 2 cos((2k + 1) pi / 4n)
+    static constexpr DampingTable makeDampingTable() noexcept
+    {
+        DampingTable table {};
+
+        for (int numSections = 1; numSections <= maxSections; ++numSections)
+            for (int section = 0; section < numSections; ++section)
+                table[(size_t)numSections - 1][(size_t)section]
+                    = 2.0 * cosine((2 * section + 1) * juce::MathConstants<double>::pi / (4.0 * numSections));
+
+        return table;
+    }
+
+private:
+    // std::cos is not constexpr; the angles are below pi / 2, where 16 Taylor terms are exact to double precision
+    static constexpr double cosine(double x) noexcept
+    {
+        double term = 1.0, sum = 1.0;
+
+        for (int n = 1; n < 16; ++n)
+        {
+            term *= -x * x / ((2.0 * n - 1.0) * (2.0 * n));
+            sum += term;
+        }
+
+        return sum;
+    }
+};
+
+struct SosDesigner
+{
+    static constexpr int maxCutSections = ButterworthTable::maxSections;
+
+    static double getButterworthDamping(int section, int numSections) noexcept
+    {
+        jassert(numSections > 0 && numSections <= maxCutSections && section >= 0 && section < numSections);
+        return butterworthDamping[(size_t)numSections - 1][(size_t)section];
+    }
+
+    // the frequency dependent part of a bell, so its gain can move every few samples
+    // for one std::pow and a division instead of the trigonometry of a full design
+    struct BellPrototype
+    {
+        double alpha { 0 }, c2 { -2 }; // biquad
+        double g { 0 }, invQ { 1 };    // state variable filter
+    };
+
+    static BellPrototype prepareBell(double frequency, double quality, double sampleRate) noexcept
+    {
+        const double omega = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+
+        return { std::sin(omega) / (quality * 2.0),
+                 -2.0 * std::cos(omega),
+                 std::tan(0.5 * omega),
+                 1.0 / quality };
+    }
+
+    static BiquadCoefficients designBell(const BellPrototype& bell, double gainInDecibels) noexcept
+    {
+        const double A = std::pow(10.0, gainInDecibels / 40.0);
+        const double alphaTimesA = bell.alpha * A;
+        const double alphaOverA = bell.alpha / A;
+        const double a0Inv = 1.0 / (1.0 + alphaOverA);
+
+        return { (1.0 + alphaTimesA) * a0Inv,
+                 bell.c2 * a0Inv,
+                 (1.0 - alphaTimesA) * a0Inv,
+                 bell.c2 * a0Inv,
+                 (1.0 - alphaOverA) * a0Inv };
+    }
+
+    // RBJ peak, the same design as juce::dsp::IIR::Coefficients::makePeakFilter
+    static BiquadCoefficients designPeak(double frequency, double quality, double gainInDecibels, double sampleRate) noexcept
+    {
+        return designBell(prepareBell(frequency, quality, sampleRate), gainInDecibels);
+    }
+
+    // RBJ shelves, quality 1 / sqrt(2) gives the steepest slope without overshoot
+    static BiquadCoefficients designLowShelf(double frequency, double quality, double gainInDecibels, double sampleRate) noexcept
+    {
+        const double A = std::pow(10.0, gainInDecibels / 40.0);
+        const double omega = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+        const double cosOmega = std::cos(omega);
+        const double beta = std::sin(omega) * std::sqrt(A) / quality;
+        const double aPlus1 = A + 1.0, aMinus1 = A - 1.0;
+
+        return normalise(A * (aPlus1 - aMinus1 * cosOmega + beta),
+                         2.0 * A * (aMinus1 - aPlus1 * cosOmega),
+                         A * (aPlus1 - aMinus1 * cosOmega - beta),
+                         aPlus1 + aMinus1 * cosOmega + beta,
+                         -2.0 * (aMinus1 + aPlus1 * cosOmega),
+                         aPlus1 + aMinus1 * cosOmega - beta);
+    }
+
+    static BiquadCoefficients designHighShelf(double frequency, double quality, double gainInDecibels, double sampleRate) noexcept
+    {
+        const double A = std::pow(10.0, gainInDecibels / 40.0);
+        const double omega = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+        const double cosOmega = std::cos(omega);
+        const double beta = std::sin(omega) * std::sqrt(A) / quality;
+        const double aPlus1 = A + 1.0, aMinus1 = A - 1.0;
+
+        return normalise(A * (aPlus1 + aMinus1 * cosOmega + beta),
+                         -2.0 * A * (aMinus1 + aPlus1 * cosOmega),
+                         A * (aPlus1 + aMinus1 * cosOmega - beta),
+                         aPlus1 - aMinus1 * cosOmega + beta,
+                         2.0 * (aMinus1 - aPlus1 * cosOmega),
+                         aPlus1 - aMinus1 * cosOmega - beta);
+    }
+
+    // high shelf pivoting around its frequency: -gain / 2 below, +gain / 2 above
+    static BiquadCoefficients designTilt(double frequency, double quality, double gainInDecibels, double sampleRate) noexcept
+    {
+        auto c = designHighShelf(frequency, quality, gainInDecibels, sampleRate);
+        const double invA = std::pow(10.0, -gainInDecibels / 40.0);
+
+        c.b0 *= invA;
+        c.b1 *= invA;
+        c.b2 *= invA;
+
+        return c;
+    }
+
+    static BiquadCoefficients designNotch(double frequency, double quality, double sampleRate) noexcept
+    {
+        const double omega = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+        const double c2 = -2.0 * std::cos(omega);
+        const double alpha = std::sin(omega) / (quality * 2.0);
+
+        return normalise(1.0, c2, 1.0, 1.0 + alpha, c2, 1.0 - alpha);
+    }
+
+    // resonant 12 dB/oct cuts, unlike designCut the quality is free
+    static BiquadCoefficients designLowPass(double frequency, double quality, double sampleRate) noexcept
+    {
+        const double omega = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+        const double cosOmega = std::cos(omega);
+        const double alpha = std::sin(omega) / (quality * 2.0);
+
+        return normalise(0.5 * (1.0 - cosOmega), 1.0 - cosOmega, 0.5 * (1.0 - cosOmega), 1.0 + alpha, -2.0 * cosOmega, 1.0 - alpha);
+    }
+
+    static BiquadCoefficients designHighPass(double frequency, double quality, double sampleRate) noexcept
+    {
+        const double omega = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+        const double cosOmega = std::cos(omega);
+        const double alpha = std::sin(omega) / (quality * 2.0);
+
+        return normalise(0.5 * (1.0 + cosOmega), -(1.0 + cosOmega), 0.5 * (1.0 + cosOmega), 1.0 + alpha, -2.0 * cosOmega, 1.0 - alpha);
+    }
+
+    // Butterworth of order 2 * numSections, the same response as the FilterDesign high order methods
+    static void designCut(BiquadCoefficients* sections, int numSections, double cutFrequency, double sampleRate, bool isHighPass) noexcept
+    {
+        if (numSections == 0)
+            return;
+
+        const double tanOmega = std::tan(juce::MathConstants<double>::pi * cutFrequency / sampleRate);
+        const double n = isHighPass ? tanOmega : 1.0 / tanOmega;
+        const double nSquared = n * n;
+
+        for (int i = 0; i < numSections; ++i)
+        {
+            const double invQ = getButterworthDamping(i, numSections);
+            const double c1 = 1.0 / (1.0 + invQ * n + nSquared);
+
+            sections[i] = { c1,
+                            c1 * (isHighPass ? -2.0 : 2.0),
+                            c1,
+                            c1 * 2.0 * (isHighPass ? nSquared - 1.0 : 1.0 - nSquared),
+                            c1 * (1.0 - invQ * n + nSquared) };
+        }
+    }
+
+    // bell after Simper / Zavalishin, same response as designBell
+    static SvfCoefficients designSvfBell(const BellPrototype& bell, double gainInDecibels) noexcept
+    {
+        const double A = std::pow(10.0, gainInDecibels / 40.0);
+        const double k = bell.invQ / A;
+
+        return makeSvfCoefficients(bell.g, k, 1.0, k * (A * A - 1.0), 0.0);
+    }
+
+    static SvfCoefficients designSvfPeak(double frequency, double quality, double gainInDecibels, double sampleRate) noexcept
+    {
+        return designSvfBell(prepareBell(frequency, quality, sampleRate), gainInDecibels);
+    }
+
+    // shelves after Simper, the cutoff is moved by sqrt(A) so the response matches the RBJ designs
+    static SvfCoefficients designSvfLowShelf(double frequency, double quality, double gainInDecibels, double sampleRate) noexcept
+    {
+        const double A = std::pow(10.0, gainInDecibels / 40.0);
+        const double g = std::tan(juce::MathConstants<double>::pi * frequency / sampleRate) / std::sqrt(A);
+        const double k = 1.0 / quality;
+
+        return makeSvfCoefficients(g, k, 1.0, k * (A - 1.0), A * A - 1.0);
+    }
+
+    static SvfCoefficients designSvfHighShelf(double frequency, double quality, double gainInDecibels, double sampleRate) noexcept
+    {
+        const double A = std::pow(10.0, gainInDecibels / 40.0);
+        const double g = std::tan(juce::MathConstants<double>::pi * frequency / sampleRate) * std::sqrt(A);
+        const double k = 1.0 / quality;
+
+        return makeSvfCoefficients(g, k, A * A, k * (1.0 - A) * A, 1.0 - A * A);
+    }
+
+    static SvfCoefficients designSvfTilt(double frequency, double quality, double gainInDecibels, double sampleRate) noexcept
+    {
+        auto c = designSvfHighShelf(frequency, quality, gainInDecibels, sampleRate);
+        const double invA = std::pow(10.0, -gainInDecibels / 40.0);
+
+        c.m0 *= invA;
+        c.m1 *= invA;
+        c.m2 *= invA;
+
+        return c;
+    }
+
+    static SvfCoefficients designSvfNotch(double frequency, double quality, double sampleRate) noexcept
+    {
+        const double g = std::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+        const double k = 1.0 / quality;
+
+        return makeSvfCoefficients(g, k, 1.0, -k, 0.0);
+    }
+
+    static SvfCoefficients designSvfLowPass(double frequency, double quality, double sampleRate) noexcept
+    {
+        const double g = std::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+
+        return makeSvfCoefficients(g, 1.0 / quality, 0.0, 0.0, 1.0);
+    }
+
+    static SvfCoefficients designSvfHighPass(double frequency, double quality, double sampleRate) noexcept
+    {
+        const double g = std::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+        const double k = 1.0 / quality;
+
+        return makeSvfCoefficients(g, k, 1.0, -k, -1.0);
+    }
+
+    static void designSvfCut(SvfCoefficients* sections, int numSections, double cutFrequency, double sampleRate, bool isHighPass) noexcept
+    {
+        if (numSections == 0)
+            return;
+
+        // all sections of a cut share the same cutoff, so one tan() per cut
+        const double g = std::tan(juce::MathConstants<double>::pi * cutFrequency / sampleRate);
+
+        for (int i = 0; i < numSections; ++i)
+        {
+            const double k = getButterworthDamping(i, numSections);
+
+            sections[i] = isHighPass ? makeSvfCoefficients(g, k, 1.0, -k, -1.0)
+                                     : makeSvfCoefficients(g, k, 0.0, 0.0, 1.0);
+        }
+    }
+
+private:
+    static BiquadCoefficients normalise(double b0, double b1, double b2, double a0, double a1, double a2) noexcept
+    {
+        const double a0Inv = 1.0 / a0;
+        return { b0 * a0Inv, b1 * a0Inv, b2 * a0Inv, a1 * a0Inv, a2 * a0Inv };
+    }
+
+    static constexpr ButterworthTable::DampingTable butterworthDamping = ButterworthTable::makeDampingTable();
+};
@@ -0,0 +1,250 @@
+/*
+  ==============================================================================
+
+    SpectrumAnalyzer.h
+
+    Spectrum of the signal before and after the EQ for the editor. The audio
+    thread only mixes each block down to mono into a wait-free single
+    producer / single consumer FIFO; windowing, FFT, averaging and turning
+    the spectrum into a path run on a shared background thread. The path is
+    log-binned to a fixed number of points per pixel, so drawing it costs
+    the same whatever the FFT size.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "TripleBuffer.h"
+
+// audio thread -> analyser hand-off, no locks and no allocation after construction
+class AnalyzerFifo
+{
+public:
+    explicit AnalyzerFifo(int capacity = 1 << 15)
+        : fifo(capacity), samples((size_t)capacity)
+    {
+    }
+
+    void setSampleRate(double newSampleRate) noexcept { sampleRate.store(newSampleRate); }
+    double getSampleRate() const noexcept { return sampleRate.load(); }
+
+    // producer side: averages the channels into the FIFO, or drops the block if the consumer fell behind
+    template <typename SampleType>
+    void push(const SampleType* const* channels, int numChannels, int numSamples) noexcept
+    {
+        if (numChannels <= 0 || fifo.getFreeSpace() < numSamples)
+            return;
+
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite(numSamples, start1, size1, start2, size2);
+
+        mixDown(channels, numChannels, 0, start1, size1);
+        mixDown(channels, numChannels, size1, start2, size2);
+
+        fifo.finishedWrite(size1 + size2);
+    }
+
+    // consumer side: returns the number of samples copied
+    int pop(float* destination, int maxSamples) noexcept
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead(juce::jmin(maxSamples, fifo.getNumReady()), start1, size1, start2, size2);
+
+        std::copy_n(samples.data() + start1, size1, destination);
+        std::copy_n(samples.data() + start2, size2, destination + size1);
+
+        fifo.finishedRead(size1 + size2);
+        return size1 + size2;
+    }
+
+    int getNumReady() const noexcept { return fifo.getNumReady(); }
+
+private:
+    void mixDown(const float* const* channels, int numChannels, int sourceStart, int destinationStart, int numSamples) noexcept
+    {
+        if (numSamples <= 0)
+            return;
+
+        auto* destination = samples.data() + destinationStart;
+        const float gain = 1.f / (float)numChannels;
+
+        juce::FloatVectorOperations::copyWithMultiply(destination, channels[0] + sourceStart, gain, numSamples);
+
+        for (int ch = 1; ch < numChannels; ++ch)
+            juce::FloatVectorOperations::addWithMultiply(destination, channels[ch] + sourceStart, gain, numSamples);
+    }
+
+    void mixDown(const double* const* channels, int numChannels, int sourceStart, int destinationStart, int numSamples) noexcept
+    {
+        auto* destination = samples.data() + destinationStart;
+        const double gain = 1.0 / numChannels;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            double sum = 0.0;
+
+            for (int ch = 0; ch < numChannels; ++ch)
+                sum += channels[ch][sourceStart + i];
+
+            destination[i] = (float)(sum * gain);
+        }
+    }
+
+    juce::AbstractFifo fifo;
+    std::vector<float> samples;
+    std::atomic<double> sampleRate { 44100.0 };
+
+    JUCE_DECLARE_NON_COPYABLE(AnalyzerFifo)
+};
+
+//==============================================================================
+class SpectrumAnalyzer : private juce::TimeSliceClient
+{
+public:
+    static constexpr int fftOrder = 11;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int hopSize = fftSize / 4;
+
+    static constexpr float minDecibels = -96.f;
+    static constexpr float maxDecibels = 0.f;
+
+    explicit SpectrumAnalyzer(AnalyzerFifo& fifoToUse)
+        : fifo(fifoToUse)
+    {
+        levels.fill(minDecibels);
+        analyzerThread->addTimeSliceClient(this);
+    }
+
+    ~SpectrumAnalyzer() override
+    {
+        analyzerThread->removeTimeSliceClient(this);
+    }
+
+    // GUI side: where the path should be drawn, frequencies from 20 Hz to 20 kHz left to right
+    void setBounds(juce::Rectangle<float> newBounds)
+    {
+        boundsBuffer.getWriteBuffer() = newBounds;
+        boundsBuffer.publish();
+    }
+
+    // GUI side: returns true if a new path has been published since the last call
+    bool pullPath() noexcept { return pathBuffer.pull(); }
+    const juce::Path& getPath() const noexcept { return pathBuffer.getReadBuffer(); }
+
+private:
+    struct AnalyzerThread : juce::TimeSliceThread
+    {
+        AnalyzerThread() : juce::TimeSliceThread("SimpleEQ Analyzer") { startThread(); }
+        ~AnalyzerThread() override { stopThread(1000); }
+    };
+
+    int useTimeSlice() override
+    {
+        const bool boundsChanged = boundsBuffer.pull();
+
+        // collect everything that arrived, one hop at a time
+        bool hasNewSpectrum = false;
+
+        while (fifo.getNumReady() >= hopSize)
+        {
+            std::copy(history.begin() + hopSize, history.end(), history.begin());
+            fifo.pop(history.data() + fftSize - hopSize, hopSize);
+
+            performAnalysis();
+            hasNewSpectrum = true;
+        }
+
+        if (hasNewSpectrum || boundsChanged)
+            generatePath(boundsBuffer.getReadBuffer());
+
+        return hasNewSpectrum ? 10 : 20;
+    }
+
+    void performAnalysis() noexcept
+    {
+        std::copy(history.begin(), history.end(), fftData.begin());
+        std::fill(fftData.begin() + fftSize, fftData.end(), 0.f);
+
+        window.multiplyWithWindowingTable(fftData.data(), (size_t)fftSize);
+        fft.performFrequencyOnlyForwardTransform(fftData.data());
+
+        // a full scale sine reads 0 dB: fftSize / 2 for the transform, 1 / 2 for the Hann window
+        const float normalisation = 4.f / (float)fftSize;
+
+        for (size_t bin = 0; bin < levels.size(); ++bin)
+        {
+            auto level = juce::Decibels::gainToDecibels(fftData[bin] * normalisation, minDecibels);
+            levels[bin] += averaging * (level - levels[bin]);
+        }
+    }
+
+    void generatePath(juce::Rectangle<float> bounds)
+    {
+        if (bounds.isEmpty())
+            return;
+
+        auto& path = pathBuffer.getWriteBuffer();
+        path.clear();
+
+        const int numPoints = juce::jmax(2, (int)bounds.getWidth() / pixelsPerPoint);
+        const double binsPerHz = fftSize / fifo.getSampleRate();
+
+        auto binForPoint = [&](double point)
+            {
+                return juce::mapToLog10(point / (numPoints - 1), 20.0, 20000.0) * binsPerHz;
+            };
+
+        for (int point = 0; point < numPoints; ++point)
+        {
+            // the loudest bin within this point's frequency span, interpolated where a point is narrower than a bin
+            const double lowBin = binForPoint(point - 0.5);
+            const double highBin = binForPoint(point + 0.5);
+
+            float level;
+
+            if (highBin - lowBin < 1.0)
+            {
+                const double bin = juce::jlimit(0.0, (double)numBins - 2.0, binForPoint(point));
+                const auto index = (size_t)bin;
+                level = juce::jmap((float)(bin - (double)index), levels[index], levels[index + 1]);
+            }
+            else
+            {
+                const auto first = (size_t)juce::jlimit(0, numBins - 1, (int)std::ceil(lowBin));
+                const auto last = (size_t)juce::jlimit(0, numBins - 1, (int)highBin);
+                level = *std::max_element(levels.begin() + first, levels.begin() + last + 1);
+            }
+
+            const float x = bounds.getX() + bounds.getWidth() * (float)point / (float)(numPoints - 1);
+            const float y = juce::jmap(level, minDecibels, maxDecibels, bounds.getBottom(), bounds.getY());
+
+            if (point == 0)
+                path.startNewSubPath(x, y);
+            else
+                path.lineTo(x, y);
+        }
+
+        pathBuffer.publish();
+    }
+
+    static constexpr int numBins = fftSize / 2 + 1;
+    static constexpr int pixelsPerPoint = 2;
+    static constexpr float averaging = 0.2f;
+
+    AnalyzerFifo& fifo;
+    juce::SharedResourcePointer<AnalyzerThread> analyzerThread;
+
+    juce::dsp::FFT fft { fftOrder };
+    juce::dsp::WindowingFunction<float> window { (size_t)fftSize, juce::dsp::WindowingFunction<float>::hann, false };
+
+    std::array<float, fftSize> history {};
+    std::array<float, 2 * fftSize> fftData {};
+    std::array<float, numBins> levels {};
+
+    TripleBuffer<juce::Rectangle<float>> boundsBuffer;
+    TripleBuffer<juce::Path> pathBuffer;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectrumAnalyzer)
+};
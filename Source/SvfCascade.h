@@ -0,0 +1,78 @@
+/*
+  ==============================================================================
+
+    SvfCascade.h
+
+    Topology-preserving (TPT / Zavalishin, trapezoidal integrator) state
+    variable filter sections for FilterCascade. The state are the integrator
+    outputs, so coefficients can change every sample without the transients
+    and precision problems a direct form suffers from at low cutoffs.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "FilterCascade.h"
+
+// g = tan(pi * fc / fs), k = 1 / Q, a1 = 1 / (1 + g * (g + k)), a2 = g * a1, a3 = g * a2,
+// output = m0 * input + m1 * bandpass + m2 * lowpass
+struct SvfCoefficients
+{
+    double a1 { 1 }, a2 { 0 }, a3 { 0 };
+    double m0 { 1 }, m1 { 0 }, m2 { 0 };
+};
+
+inline SvfCoefficients makeSvfCoefficients(double g, double k, double m0, double m1, double m2)
+{
+    const double a1 = 1.0 / (1.0 + g * (g + k));
+    const double a2 = g * a1;
+    const double a3 = g * a2;
+
+    return { a1, a2, a3, m0, m1, m2 };
+}
+
+struct SvfSection
+{
+    using Coefficients = SvfCoefficients;
+
+    static constexpr int numCoefficients = 6;
+    static constexpr int numStates = 2;
+
+    static std::array<double, numCoefficients> toArray(const SvfCoefficients& c) noexcept
+    {
+        return { c.a1, c.a2, c.a3, c.m0, c.m1, c.m2 };
+    }
+
+    template <typename SIMDType, typename SampleType>
+    static void process(const SIMDType* coefficients, SIMDType* state, SampleType* frames, int numFrames) noexcept
+    {
+        constexpr int numLanes = (int)SIMDType::SIMDNumElements;
+
+        const auto a1 = coefficients[0], a2 = coefficients[1], a3 = coefficients[2];
+        const auto m0 = coefficients[3], m1 = coefficients[4], m2 = coefficients[5];
+        auto ic1eq = state[0], ic2eq = state[1];
+
+        for (int i = 0; i < numFrames; ++i)
+        {
+            auto* frame = frames + i * numLanes;
+
+            const auto v0 = SIMDType::fromRawArray(frame);
+            const auto v3 = v0 - ic2eq;
+            const auto v1 = a1 * ic1eq + a2 * v3;
+            const auto v2 = ic2eq + a2 * ic1eq + a3 * v3;
+
+            ic1eq = v1 + v1 - ic1eq;
+            ic2eq = v2 + v2 - ic2eq;
+
+            const auto out = m0 * v0 + m1 * v1 + m2 * v2;
+            out.copyToRawArray(frame);
+        }
+
+        state[0] = ic1eq;
+        state[1] = ic2eq;
+    }
+};
+
+template <typename SampleType>
+using SvfCascade = FilterCascade<SampleType, SvfSection>;
@@ -0,0 +1,55 @@
+/*
+  ==============================================================================
+
+    TripleBuffer.h
+
+    Lock-free hand-off of the latest value from one writer thread to one
+    reader thread. The writer never blocks the reader and vice versa, the
+    reader always sees a complete value and intermediate values may be
+    skipped.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+
+template <typename ValueType>
+class TripleBuffer
+{
+public:
+    TripleBuffer() = default;
+
+    // writer side: fill getWriteBuffer(), then publish() it
+    ValueType& getWriteBuffer() noexcept { return buffers[writeIndex]; }
+
+    void publish() noexcept
+    {
+        auto previous = middle.exchange(writeIndex | freshBit, std::memory_order_acq_rel);
+        writeIndex = previous & indexMask;
+    }
+
+    // reader side: returns true if a newer value has been published since the last pull
+    bool pull() noexcept
+    {
+        if ((middle.load(std::memory_order_relaxed) & freshBit) == 0)
+            return false;
+
+        auto previous = middle.exchange(readIndex, std::memory_order_acq_rel);
+        readIndex = previous & indexMask;
+        return true;
+    }
+
+    const ValueType& getReadBuffer() const noexcept { return buffers[readIndex]; }
+
+private:
+    static constexpr int indexMask = 3;
+    static constexpr int freshBit = 4;
+
+    std::array<ValueType, 3> buffers {};
+    std::atomic<int> middle { 1 };
+    int writeIndex = 0;
+    int readIndex = 2;
+};
@@ -0,0 +1,192 @@
+/*
+  ==============================================================================
+
+    BinaryStateTests.cpp
+
+    BinaryState round trips and the compatibility rules of the format:
+    states with more values than the reader knows (a newer version) and
+    with fewer (an older one), damaged headers and non-finite values.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/BinaryState.h"
+
+namespace
+{
+    // the parameters need a processor to notify; the first numParameters of a fixed list, in state order
+    class TestProcessor : public juce::AudioProcessor
+    {
+    public:
+        explicit TestProcessor(int numParameters)
+        {
+            auto add = [this, numParameters](std::unique_ptr<juce::RangedAudioParameter> parameter)
+            {
+                if ((int)parameters.size() < numParameters)
+                {
+                    parameters.push_back(parameter.get());
+                    addParameter(parameter.release());
+                }
+            };
+
+            add(std::make_unique<juce::AudioParameterFloat>("Freq", "Freq",
+                                                            juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.25f), 750.f));
+            add(std::make_unique<juce::AudioParameterFloat>("Gain", "Gain",
+                                                            juce::NormalisableRange<float>(-24.f, 24.f, 0.5f, 1.f), 0.f));
+            add(std::make_unique<juce::AudioParameterChoice>("Slope", "Slope",
+                                                             juce::StringArray { "12", "24", "36", "48" }, 1));
+            add(std::make_unique<juce::AudioParameterBool>("Enabled", "Enabled", true));
+        }
+
+        BinaryState::Parameters parameters;
+
+        const juce::String getName() const override { return "BinaryStateTests"; }
+        void prepareToPlay(double, int) override {}
+        void releaseResources() override {}
+        void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override {}
+        double getTailLengthSeconds() const override { return 0.0; }
+        bool acceptsMidi() const override { return false; }
+        bool producesMidi() const override { return false; }
+        juce::AudioProcessorEditor* createEditor() override { return nullptr; }
+        bool hasEditor() const override { return false; }
+        int getNumPrograms() override { return 1; }
+        int getCurrentProgram() override { return 0; }
+        void setCurrentProgram(int) override {}
+        const juce::String getProgramName(int) override { return {}; }
+        void changeProgramName(int, const juce::String&) override {}
+        void getStateInformation(juce::MemoryBlock&) override {}
+        void setStateInformation(const void*, int) override {}
+    };
+
+    float getPlainValue(const juce::RangedAudioParameter* parameter)
+    {
+        return parameter->convertFrom0to1(parameter->getValue());
+    }
+
+    void setPlainValue(juce::RangedAudioParameter* parameter, float value)
+    {
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+    }
+
+    // plain values that differ from every default
+    void setTestValues(TestProcessor& processor)
+    {
+        const float values[] { 3150.f, -7.5f, 3.f, 0.f };
+
+        for (size_t i = 0; i < processor.parameters.size(); ++i)
+            setPlainValue(processor.parameters[i], values[i]);
+    }
+}
+
+//==============================================================================
+class BinaryStateTests : public juce::UnitTest
+{
+public:
+    BinaryStateTests() : juce::UnitTest("BinaryState", "SimpleEQ") {}
+
+    void runTest() override
+    {
+        beginTest("Round trip");
+        {
+            TestProcessor source(4), destination(4);
+            setTestValues(source);
+
+            juce::MemoryBlock state;
+            BinaryState::write(state, source.parameters);
+
+            expectEquals((int)state.getSize(), BinaryState::headerSize + 4 * 4);
+            expect(BinaryState::isBinaryState(state.getData(), (int)state.getSize()));
+            expect(BinaryState::read(state.getData(), (int)state.getSize(), destination.parameters));
+            expectSameValues(destination, source, 4);
+        }
+
+        beginTest("A state with more values than parameters");
+        {
+            TestProcessor newer(4), older(2);
+            setTestValues(newer);
+
+            juce::MemoryBlock state;
+            BinaryState::write(state, newer.parameters);
+
+            // the values the reader doesn't know are skipped
+            expect(BinaryState::read(state.getData(), (int)state.getSize(), older.parameters));
+            expectSameValues(older, newer, 2);
+        }
+
+        beginTest("A state with fewer values than parameters");
+        {
+            TestProcessor older(2), newer(4), defaults(4);
+            setTestValues(older);
+            setTestValues(newer);
+
+            juce::MemoryBlock state;
+            BinaryState::write(state, older.parameters);
+
+            // the parameters the state doesn't have go back to their defaults, not to the values before
+            expect(BinaryState::read(state.getData(), (int)state.getSize(), newer.parameters));
+            expectSameValues(newer, older, 2);
+
+            for (size_t i = 2; i < 4; ++i)
+                expectEquals(getPlainValue(newer.parameters[i]), getPlainValue(defaults.parameters[i]));
+        }
+
+        beginTest("Damaged states change nothing");
+        {
+            TestProcessor source(4), destination(4), expected(4);
+            setTestValues(destination);
+            setTestValues(expected);
+
+            juce::MemoryBlock state;
+            BinaryState::write(state, source.parameters);
+
+            auto badMagic = state;
+            static_cast<char*>(badMagic.getData())[0] ^= 0x20;
+            expect(! BinaryState::read(badMagic.getData(), (int)badMagic.getSize(), destination.parameters), "magic");
+
+            auto badVersion = state;
+            std::memset(static_cast<char*>(badVersion.getData()) + 4, 0, 4);
+            expect(! BinaryState::read(badVersion.getData(), (int)badVersion.getSize(), destination.parameters), "version");
+
+            // fewer bytes than the header announces
+            expect(! BinaryState::read(state.getData(), (int)state.getSize() - 1, destination.parameters), "truncated");
+            expect(! BinaryState::read(state.getData(), BinaryState::headerSize - 1, destination.parameters), "no header");
+            expect(! BinaryState::read(nullptr, 0, destination.parameters), "empty");
+
+            expectSameValues(destination, expected, 4);
+        }
+
+        beginTest("Non-finite values fall back to the default");
+        {
+            TestProcessor source(4), destination(4), defaults(4);
+            setTestValues(source);
+            setTestValues(destination);
+
+            juce::MemoryBlock state;
+            BinaryState::write(state, source.parameters);
+
+            const float notANumber = std::numeric_limits<float>::quiet_NaN();
+            const float infinity = std::numeric_limits<float>::infinity();
+            std::memcpy(static_cast<char*>(state.getData()) + BinaryState::headerSize, &notANumber, sizeof(float));
+            std::memcpy(static_cast<char*>(state.getData()) + BinaryState::headerSize + 4, &infinity, sizeof(float));
+
+            expect(BinaryState::read(state.getData(), (int)state.getSize(), destination.parameters));
+
+            for (size_t i = 0; i < 2; ++i)
+                expectEquals(getPlainValue(destination.parameters[i]), getPlainValue(defaults.parameters[i]));
+
+            for (size_t i = 2; i < 4; ++i)
+                expectEquals(getPlainValue(destination.parameters[i]), getPlainValue(source.parameters[i]));
+        }
+    }
+
+private:
+    void expectSameValues(const TestProcessor& actual, const TestProcessor& expected, int numParameters)
+    {
+        for (size_t i = 0; i < (size_t)numParameters; ++i)
+            expectWithinAbsoluteError(getPlainValue(actual.parameters[i]), getPlainValue(expected.parameters[i]), 1.0e-3f,
+                                      actual.parameters[i]->getName(64));
+    }
+};
+
+static BinaryStateTests binaryStateTests;
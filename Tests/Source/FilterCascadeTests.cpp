@@ -0,0 +1,293 @@
+/*
+  ==============================================================================
+
+    FilterCascadeTests.cpp
+
+    The SIMD cascades against a plain per-channel transposed direct form II
+    biquad in the same precision, on random input cut into irregular blocks
+    so that the chunking inside FilterCascade::process is crossed at odd
+    offsets. The state variable sections are checked against biquads with
+    the same response.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/SosDesigner.h"
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int numTestSamples = 3000;
+
+    template <typename SampleType>
+    struct ReferenceChain
+    {
+        struct Section
+        {
+            SampleType b0, b1, b2, a1, a2;
+            SampleType s1 { 0 }, s2 { 0 };
+        };
+
+        void add(const BiquadCoefficients& c)
+        {
+            sections.push_back({ (SampleType)c.b0, (SampleType)c.b1, (SampleType)c.b2, (SampleType)c.a1, (SampleType)c.a2 });
+        }
+
+        SampleType process(SampleType x) noexcept
+        {
+            for (auto& s : sections)
+            {
+                const auto y = s.b0 * x + s.s1;
+
+                s.s1 = s.b1 * x - s.a1 * y + s.s2;
+                s.s2 = s.b2 * x - s.a2 * y;
+                x = y;
+            }
+
+            return x;
+        }
+
+        std::vector<Section> sections;
+    };
+
+    template <typename SampleType>
+    void fillWithNoise(juce::AudioBuffer<SampleType>& buffer, juce::Random& random)
+    {
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+                buffer.setSample(channel, i, (SampleType)(2.0 * random.nextDouble() - 1.0));
+    }
+
+    // runs the whole buffer through the cascade in blocks of 1 to 100 samples
+    template <typename CascadeType, typename SampleType>
+    void processInRandomBlocks(CascadeType& cascade, juce::AudioBuffer<SampleType>& buffer, juce::Random& random)
+    {
+        SampleType* channels[CascadeType::numLanes] {};
+
+        for (int offset = 0; offset < buffer.getNumSamples();)
+        {
+            const int numSamples = juce::jmin(random.nextInt({ 1, 101 }), buffer.getNumSamples() - offset);
+
+            for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+                channels[channel] = buffer.getWritePointer(channel, offset);
+
+            cascade.process(channels, buffer.getNumChannels(), numSamples);
+            offset += numSamples;
+        }
+    }
+
+    template <typename SampleType>
+    SampleType getMaxDifference(const juce::AudioBuffer<SampleType>& a, const juce::AudioBuffer<SampleType>& b)
+    {
+        SampleType maxDifference = 0;
+
+        for (int channel = 0; channel < a.getNumChannels(); ++channel)
+            for (int i = 0; i < a.getNumSamples(); ++i)
+                maxDifference = juce::jmax(maxDifference, std::abs(a.getSample(channel, i) - b.getSample(channel, i)));
+
+        return maxDifference;
+    }
+}
+
+//==============================================================================
+class FilterCascadeTests : public juce::UnitTest
+{
+public:
+    FilterCascadeTests() : juce::UnitTest("FilterCascade", "SimpleEQ") {}
+
+    void runTest() override
+    {
+        auto random = juce::Random(0x5eed);
+
+        // float leaves room for the compiler contracting multiply / adds differently in the two versions,
+        // which the 45 Hz low cut amplifies to around 1e-4
+        beginTest("Float biquad cascade matches a scalar reference");
+        {
+            for (int numChannels = 1; numChannels <= BiquadCascade<float>::numLanes; ++numChannels)
+            {
+                checkBiquadCascade<float>(random, numChannels, false, false, 1.0e-3f);
+                checkBiquadCascade<float>(random, numChannels, true, false, 1.0e-3f);
+            }
+        }
+
+        beginTest("Double biquad cascade matches a scalar reference");
+        {
+            for (int numChannels = 1; numChannels <= BiquadCascade<double>::numLanes; ++numChannels)
+            {
+                checkBiquadCascade<double>(random, numChannels, false, false, 1.0e-12);
+                checkBiquadCascade<double>(random, numChannels, true, false, 1.0e-12);
+            }
+        }
+
+        beginTest("Mid / side");
+        {
+            for (int numChannels = 2; numChannels <= BiquadCascade<float>::numLanes; ++numChannels)
+                checkBiquadCascade<float>(random, numChannels, true, true, 1.0e-3f);
+
+            checkBiquadCascade<double>(random, 2, true, true, 1.0e-12);
+        }
+
+        beginTest("No active sections pass the signal through");
+        {
+            auto cascade = std::make_unique<BiquadCascade<float>>();
+            cascade->setCoefficients(BiquadCascade<float>::FirstBand, SosDesigner::designPeak(1000.0, 1.0, 12.0, sampleRate));
+            cascade->setActiveSections(0, nullptr, 0, 0);
+
+            juce::AudioBuffer<float> buffer(2, numTestSamples);
+            fillWithNoise(buffer, random);
+
+            juce::AudioBuffer<float> input;
+            input.makeCopyOf(buffer);
+
+            processInRandomBlocks(*cascade, buffer, random);
+            expectEquals(getMaxDifference(buffer, input), 0.0f);
+        }
+
+        beginTest("State variable sections match biquads with the same response");
+        {
+            checkSvfAgainstBiquads(random);
+        }
+    }
+
+private:
+    // two low cut sections, three bands out of order and three high cut sections; with differentLanes
+    // every lane gets its own band gains
+    template <typename SampleType>
+    void checkBiquadCascade(juce::Random& random, int numChannels, bool differentLanes, bool midSide, SampleType tolerance)
+    {
+        using Cascade = BiquadCascade<SampleType>;
+        constexpr int numLanes = Cascade::numLanes;
+
+        const int numLowCut = 2, numHighCut = 3;
+        const int activeBands[] { 5, 0, 11 };
+
+        auto cascade = std::make_unique<Cascade>();
+        std::vector<ReferenceChain<SampleType>> references((size_t)numLanes);
+
+        std::array<BiquadCoefficients, SosDesigner::maxCutSections> cut;
+        SosDesigner::designCut(cut.data(), numLowCut, 45.0, sampleRate, true);
+
+        for (int i = 0; i < numLowCut; ++i)
+        {
+            cascade->setCoefficients(Cascade::FirstLowCut + i, cut[(size_t)i]);
+
+            for (auto& reference : references)
+                reference.add(cut[(size_t)i]);
+        }
+
+        for (auto band : activeBands)
+        {
+            for (int lane = 0; lane < numLanes; ++lane)
+            {
+                const double gain = differentLanes ? -12.0 + 5.0 * lane + band : 3.0 + band;
+                const auto c = SosDesigner::designPeak(150.0 * (band + 1), 1.5, gain, sampleRate);
+
+                cascade->setCoefficients(Cascade::FirstBand + band, lane, c);
+                references[(size_t)lane].add(c);
+            }
+        }
+
+        SosDesigner::designCut(cut.data(), numHighCut, 9000.0, sampleRate, false);
+
+        for (int i = 0; i < numHighCut; ++i)
+        {
+            cascade->setCoefficients(Cascade::FirstHighCut + i, cut[(size_t)i]);
+
+            for (auto& reference : references)
+                reference.add(cut[(size_t)i]);
+        }
+
+        cascade->setActiveSections(numLowCut, activeBands, (int)std::size(activeBands), numHighCut);
+        cascade->setMidSide(midSide);
+
+        juce::AudioBuffer<SampleType> buffer(numChannels, numTestSamples);
+        fillWithNoise(buffer, random);
+
+        juce::AudioBuffer<SampleType> expected;
+        expected.makeCopyOf(buffer);
+
+        for (int i = 0; i < numTestSamples; ++i)
+        {
+            int firstChannel = 0;
+
+            if (midSide)
+            {
+                const auto half = SampleType(0.5);
+                const auto left = expected.getSample(0, i), right = expected.getSample(1, i);
+                const auto mid = references[0].process(half * (left + right));
+                const auto side = references[1].process(half * (left - right));
+
+                expected.setSample(0, i, mid + side);
+                expected.setSample(1, i, mid - side);
+                firstChannel = 2;
+            }
+
+            for (int channel = firstChannel; channel < numChannels; ++channel)
+                expected.setSample(channel, i, references[(size_t)channel].process(expected.getSample(channel, i)));
+        }
+
+        processInRandomBlocks(*cascade, buffer, random);
+
+        expectLessOrEqual(getMaxDifference(buffer, expected), tolerance,
+                          juce::String(numChannels) + " channels" + (differentLanes ? ", per lane" : "") + (midSide ? ", mid / side" : ""));
+    }
+
+    void checkSvfAgainstBiquads(juce::Random& random)
+    {
+        auto svf = std::make_unique<SvfCascade<double>>();
+        auto biquad = std::make_unique<BiquadCascade<double>>();
+
+        const int numLowCut = 4, numHighCut = 2;
+        const int activeBands[] { 0, 1, 2, 3 };
+
+        std::array<SvfCoefficients, SosDesigner::maxCutSections> svfCut;
+        std::array<BiquadCoefficients, SosDesigner::maxCutSections> biquadCut;
+
+        SosDesigner::designSvfCut(svfCut.data(), numLowCut, 30.0, sampleRate, true);
+        SosDesigner::designCut(biquadCut.data(), numLowCut, 30.0, sampleRate, true);
+
+        for (int i = 0; i < numLowCut; ++i)
+        {
+            svf->setCoefficients(SvfCascade<double>::FirstLowCut + i, svfCut[(size_t)i]);
+            biquad->setCoefficients(BiquadCascade<double>::FirstLowCut + i, biquadCut[(size_t)i]);
+        }
+
+        SosDesigner::designSvfCut(svfCut.data(), numHighCut, 14000.0, sampleRate, false);
+        SosDesigner::designCut(biquadCut.data(), numHighCut, 14000.0, sampleRate, false);
+
+        for (int i = 0; i < numHighCut; ++i)
+        {
+            svf->setCoefficients(SvfCascade<double>::FirstHighCut + i, svfCut[(size_t)i]);
+            biquad->setCoefficients(BiquadCascade<double>::FirstHighCut + i, biquadCut[(size_t)i]);
+        }
+
+        svf->setCoefficients(SvfCascade<double>::FirstBand, SosDesigner::designSvfPeak(700.0, 2.0, -9.0, sampleRate));
+        biquad->setCoefficients(BiquadCascade<double>::FirstBand, SosDesigner::designPeak(700.0, 2.0, -9.0, sampleRate));
+
+        svf->setCoefficients(SvfCascade<double>::FirstBand + 1, SosDesigner::designSvfLowShelf(200.0, 0.7071, 6.0, sampleRate));
+        biquad->setCoefficients(BiquadCascade<double>::FirstBand + 1, SosDesigner::designLowShelf(200.0, 0.7071, 6.0, sampleRate));
+
+        svf->setCoefficients(SvfCascade<double>::FirstBand + 2, SosDesigner::designSvfHighShelf(5000.0, 0.7071, -4.0, sampleRate));
+        biquad->setCoefficients(BiquadCascade<double>::FirstBand + 2, SosDesigner::designHighShelf(5000.0, 0.7071, -4.0, sampleRate));
+
+        svf->setCoefficients(SvfCascade<double>::FirstBand + 3, SosDesigner::designSvfNotch(3000.0, 4.0, sampleRate));
+        biquad->setCoefficients(BiquadCascade<double>::FirstBand + 3, SosDesigner::designNotch(3000.0, 4.0, sampleRate));
+
+        svf->setActiveSections(numLowCut, activeBands, (int)std::size(activeBands), numHighCut);
+        biquad->setActiveSections(numLowCut, activeBands, (int)std::size(activeBands), numHighCut);
+
+        juce::AudioBuffer<double> svfBuffer(2, numTestSamples);
+        fillWithNoise(svfBuffer, random);
+
+        juce::AudioBuffer<double> biquadBuffer;
+        biquadBuffer.makeCopyOf(svfBuffer);
+
+        processInRandomBlocks(*svf, svfBuffer, random);
+        processInRandomBlocks(*biquad, biquadBuffer, random);
+
+        expectLessOrEqual(getMaxDifference(svfBuffer, biquadBuffer), 1.0e-9);
+    }
+};
+
+static FilterCascadeTests filterCascadeTests;
@@ -0,0 +1,58 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Console runner for the SimpleEQ unit tests: the DSP building blocks
+    (SosDesigner, FilterCascade) checked against JUCE's own designs and
+    plain scalar filters, and the BinaryState plugin state format. Runs
+    every test in the "SimpleEQ" category, or only the one named with
+    --test, and fails the exit code on any failure.
+
+    usage: SimpleEQTests [--test=<name, e.g. FilterCascade>]
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+
+#include <iostream>
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args(argc, argv);
+
+    juce::UnitTestRunner runner;
+    runner.setAssertOnFailure(false);
+
+    if (args.containsOption("--test"))
+    {
+        const auto name = args.getValueForOption("--test");
+        juce::Array<juce::UnitTest*> tests;
+
+        for (auto* test : juce::UnitTest::getTestsInCategory("SimpleEQ"))
+            if (test->getName() == name)
+                tests.add(test);
+
+        if (tests.isEmpty())
+        {
+            std::cerr << "no SimpleEQ test named " << name << std::endl;
+            return 1;
+        }
+
+        runner.runTests(tests);
+    }
+    else
+    {
+        runner.runTestsInCategory("SimpleEQ");
+    }
+
+    int numFailures = 0;
+
+    for (int i = 0; i < runner.getNumResults(); ++i)
+        numFailures += runner.getResult(i)->failures;
+
+    return numFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,163 @@
+/*
+  ==============================================================================
+
+    SosDesignerTests.cpp
+
+    SosDesigner against the JUCE designs it replaces: the RBJ sections
+    coefficient by coefficient against juce::dsp::IIR::Coefficients, the
+    Butterworth cuts by their magnitude response against the FilterDesign
+    high order methods (the section order may differ), at several sample
+    rates.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/SosDesigner.h"
+
+#include <complex>
+
+namespace
+{
+    const double sampleRates[] { 44100.0, 48000.0, 96000.0, 192000.0 };
+    const double frequencies[] { 30.0, 440.0, 2500.0, 12000.0 };
+    const double qualities[] { 0.3, 0.7071, 4.0 };
+    const double gainsInDecibels[] { -18.0, -3.0, 6.0, 24.0 };
+
+    double getMagnitudeInDecibels(const BiquadCoefficients* sections, int numSections, double frequency, double sampleRate)
+    {
+        const auto z = std::polar(1.0, -juce::MathConstants<double>::twoPi * frequency / sampleRate);
+        std::complex<double> response(1.0);
+
+        for (int i = 0; i < numSections; ++i)
+        {
+            const auto& c = sections[i];
+            response *= (c.b0 + (c.b1 + c.b2 * z) * z) / (1.0 + (c.a1 + c.a2 * z) * z);
+        }
+
+        return juce::Decibels::gainToDecibels(std::abs(response), -300.0);
+    }
+
+    double getMagnitudeInDecibels(const juce::ReferenceCountedArray<juce::dsp::IIR::Coefficients<double>>& sections,
+                                  double frequency, double sampleRate)
+    {
+        double gain = 1.0;
+
+        for (auto* section : sections)
+            gain *= section->getMagnitudeForFrequency(frequency, sampleRate);
+
+        return juce::Decibels::gainToDecibels(gain, -300.0);
+    }
+}
+
+//==============================================================================
+class SosDesignerTests : public juce::UnitTest
+{
+public:
+    SosDesignerTests() : juce::UnitTest("SosDesigner", "SimpleEQ") {}
+
+    void runTest() override
+    {
+        using JuceCoefficients = juce::dsp::IIR::Coefficients<double>;
+
+        beginTest("Butterworth damping table");
+        {
+            // 1 / Q of the sections of order 2n, as the FilterDesign high order methods compute them
+            for (int numSections = 1; numSections <= SosDesigner::maxCutSections; ++numSections)
+                for (int section = 0; section < numSections; ++section)
+                    expectWithinAbsoluteError(SosDesigner::getButterworthDamping(section, numSections),
+                                              2.0 * std::cos((2 * section + 1) * juce::MathConstants<double>::pi / (4.0 * numSections)),
+                                              1.0e-14);
+        }
+
+        beginTest("RBJ sections match juce::dsp::IIR::Coefficients");
+        {
+            for (auto sampleRate : sampleRates)
+            {
+                for (auto frequency : frequencies)
+                {
+                    for (auto quality : qualities)
+                    {
+                        for (auto gain : gainsInDecibels)
+                        {
+                            const auto gainFactor = juce::Decibels::decibelsToGain(gain);
+
+                            expectSame(SosDesigner::designPeak(frequency, quality, gain, sampleRate),
+                                       *JuceCoefficients::makePeakFilter(sampleRate, frequency, quality, gainFactor), "peak");
+                            expectSame(SosDesigner::designLowShelf(frequency, quality, gain, sampleRate),
+                                       *JuceCoefficients::makeLowShelf(sampleRate, frequency, quality, gainFactor), "low shelf");
+                            expectSame(SosDesigner::designHighShelf(frequency, quality, gain, sampleRate),
+                                       *JuceCoefficients::makeHighShelf(sampleRate, frequency, quality, gainFactor), "high shelf");
+                        }
+
+                        expectSame(SosDesigner::designNotch(frequency, quality, sampleRate),
+                                   *JuceCoefficients::makeNotch(sampleRate, frequency, quality), "notch");
+                        expectSame(SosDesigner::designLowPass(frequency, quality, sampleRate),
+                                   *JuceCoefficients::makeLowPass(sampleRate, frequency, quality), "low pass");
+                        expectSame(SosDesigner::designHighPass(frequency, quality, sampleRate),
+                                   *JuceCoefficients::makeHighPass(sampleRate, frequency, quality), "high pass");
+                    }
+                }
+            }
+        }
+
+        beginTest("Butterworth cuts match juce::dsp::FilterDesign");
+        {
+            for (auto sampleRate : sampleRates)
+            {
+                for (auto cutFrequency : { 20.0, 80.0, 1000.0, 15000.0 })
+                {
+                    for (int numSections = 1; numSections <= SosDesigner::maxCutSections; ++numSections)
+                    {
+                        const int order = 2 * numSections;
+                        std::array<BiquadCoefficients, SosDesigner::maxCutSections> sections;
+
+                        SosDesigner::designCut(sections.data(), numSections, cutFrequency, sampleRate, true);
+                        expectSameMagnitudes(sections.data(), numSections,
+                                             juce::dsp::FilterDesign<double>::designIIRHighpassHighOrderButterworthMethod(cutFrequency, sampleRate, order),
+                                             sampleRate, "high pass order " + juce::String(order));
+
+                        SosDesigner::designCut(sections.data(), numSections, cutFrequency, sampleRate, false);
+                        expectSameMagnitudes(sections.data(), numSections,
+                                             juce::dsp::FilterDesign<double>::designIIRLowpassHighOrderButterworthMethod(cutFrequency, sampleRate, order),
+                                             sampleRate, "low pass order " + juce::String(order));
+                    }
+                }
+            }
+        }
+    }
+
+private:
+    void expectSame(const BiquadCoefficients& c, const juce::dsp::IIR::Coefficients<double>& reference, const juce::String& name)
+    {
+        // normalised second order sections are stored as b0, b1, b2, a1, a2
+        const auto* raw = reference.coefficients.begin();
+        const double values[] { c.b0, c.b1, c.b2, c.a1, c.a2 };
+
+        expectEquals(reference.coefficients.size(), 5, name);
+
+        for (int i = 0; i < 5 && i < reference.coefficients.size(); ++i)
+            expectWithinAbsoluteError(values[i], raw[i], 1.0e-9, name + " coefficient " + juce::String(i));
+    }
+
+    void expectSameMagnitudes(const BiquadCoefficients* sections, int numSections,
+                              const juce::ReferenceCountedArray<juce::dsp::IIR::Coefficients<double>>& reference,
+                              double sampleRate, const juce::String& name)
+    {
+        double maxError = 0.0;
+
+        for (int i = 0; i < 200; ++i)
+        {
+            const double frequency = 20.0 * std::pow(1000.0, i / 199.0);
+            const double expected = getMagnitudeInDecibels(reference, frequency, sampleRate);
+
+            // deep in the stop band both are down to rounding noise
+            if (expected > -120.0)
+                maxError = juce::jmax(maxError, std::abs(getMagnitudeInDecibels(sections, numSections, frequency, sampleRate) - expected));
+        }
+
+        expectLessOrEqual(maxError, 1.0e-6, name);
+    }
+};
+
+static SosDesignerTests sosDesignerTests;